@@ -0,0 +1,35 @@
+set(MAZECORE_NAME mazeCore)					#GUI-free core (grid, generators, search)
+set(ASTARMAZE_CLI_NAME astarMazeCLI)		#Headless batch solver
+set(ASTARMAZE_BENCH_NAME astarMazeBench)	#Mjerenje brzine jezgra (generisanje, pretraga, crtanje)
+
+file(GLOB MAZECORE_INCS  ${CMAKE_CURRENT_LIST_DIR}/src/core/*.h)
+file(GLOB ASTARMAZE_CLI_SOURCES  ${CMAKE_CURRENT_LIST_DIR}/src/cli/*.cpp)
+file(GLOB ASTARMAZE_BENCH_SOURCES  ${CMAKE_CURRENT_LIST_DIR}/src/bench/*.cpp)
+
+# header-only library
+add_library(${MAZECORE_NAME} INTERFACE)
+target_include_directories(${MAZECORE_NAME} INTERFACE ${CMAKE_CURRENT_LIST_DIR}/src)
+target_compile_features(${MAZECORE_NAME} INTERFACE cxx_std_17)
+
+# BatchSolver koristi std::thread
+find_package(Threads REQUIRED)
+target_link_libraries(${MAZECORE_NAME} INTERFACE Threads::Threads)
+
+# Upozorenja za headless targete (GUI prati postavke natGUI-a)
+if (MSVC)
+	set(MAZECORE_WARNINGS /W4)
+else()
+	set(MAZECORE_WARNINGS -Wall -Wextra)
+endif()
+
+add_executable(${ASTARMAZE_CLI_NAME} ${ASTARMAZE_CLI_SOURCES} ${MAZECORE_INCS})
+source_group("inc\\core"      FILES ${MAZECORE_INCS})
+source_group("src"            FILES ${ASTARMAZE_CLI_SOURCES})
+target_link_libraries(${ASTARMAZE_CLI_NAME} ${MAZECORE_NAME})
+target_compile_options(${ASTARMAZE_CLI_NAME} PRIVATE ${MAZECORE_WARNINGS})
+
+add_executable(${ASTARMAZE_BENCH_NAME} ${ASTARMAZE_BENCH_SOURCES} ${MAZECORE_INCS})
+source_group("inc\\core"      FILES ${MAZECORE_INCS})
+source_group("src"            FILES ${ASTARMAZE_BENCH_SOURCES})
+target_link_libraries(${ASTARMAZE_BENCH_NAME} ${MAZECORE_NAME})
+target_compile_options(${ASTARMAZE_BENCH_NAME} PRIVATE ${MAZECORE_WARNINGS})
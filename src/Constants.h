@@ -10,3 +10,6 @@ constexpr td::UINT4 cMenuAnim = 30;
 constexpr td::UINT4 cActionNew     = 10;
 constexpr td::UINT4 cActionStep    = 20;
 constexpr td::UINT4 cActionStartStop = 30;
+constexpr td::UINT4 cActionSave    = 40;
+constexpr td::UINT4 cActionLoad    = 50;
+constexpr td::UINT4 cActionImport  = 60;
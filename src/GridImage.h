@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <gui/Image.h>
+#include <gui/Types.h>
+#include <td/Color.h>
+#include <td/ColorID.h>
+#include "core/CellRaster.h"
+
+// natGUI side of the pixel-buffer renderer: keeps a gui::Image in sync with the
+// texels of a maze::CellRaster window and shows it with one scaled draw.
+// Nearest-neighbour filtering keeps cell edges sharp when zoomed in.
+class GridImage
+{
+    gui::Image _image;
+    int _width = 0;
+    int _height = 0;
+
+public:
+    // Uploads the texels rewritten since the last sync (all of them after a resize)
+    void sync(maze::CellRaster& raster)
+    {
+        const maze::CellRaster::Region d = raster.takeDirty();
+        if (raster.texCols() != _width || raster.texRows() != _height)
+        {
+            _width = raster.texCols();
+            _height = raster.texRows();
+            _image.create(_width, _height, raster.pixels(), raster.strideBytes());
+            return;
+        }
+        if (d.empty())
+            return;
+        const std::uint32_t* first = raster.pixels() + std::size_t(d.r0) * std::size_t(_width) + std::size_t(d.c0);
+        _image.update(d.c0, d.r0, d.c1 - d.c0 + 1, d.r1 - d.r0 + 1, first, raster.strideBytes());
+    }
+
+    void draw(const gui::Rect& dst) const
+    {
+        if (_width > 0 && _height > 0)
+            _image.draw(dst, gui::Image::Filter::Nearest);
+    }
+
+    // RGBA of any ColorID, resolved by natGUI itself (system colors follow the theme)
+    static std::uint32_t rgbaOf(td::ColorID id)
+    {
+        td::BYTE r = 0, g = 0, b = 0, a = 0;
+        td::Color(id).getRGBA(r, g, b, a);
+        return maze::CellRaster::rgba(r, g, b);     // cells stay opaque
+    }
+};
@@ -2,6 +2,8 @@
 #include <functional>
 #include <chrono>
 #include <algorithm>
+#include <cmath>
+#include <string>
 
 #include <td/Types.h>
 #include <td/String.h>
@@ -23,16 +25,25 @@ class MainView : public gui::View
 {
 public:
     using FnUpdateUI = std::function<void()>;
-    using FnStatus   = std::function<void(const td::String& msg, int visited, int pathLen, int timeMS)>;
+    using FnStatus   = std::function<void(const td::String& msg, const maze::SearchStats& stats, int timeMS)>;
 
 private:
     // Controls
     gui::Label _lblAlg;
     gui::ComboBox _cmbAlg;
 
+    gui::Label _lblOpen;
+    gui::ComboBox _cmbOpen;
+
+    gui::Label _lblHeuristic;
+    gui::ComboBox _cmbHeuristic;
+
     gui::Label _lblSpeed;
     gui::Slider _slSpeed;
 
+    gui::Label _lblTimeline;
+    gui::Slider _slTimeline;
+
     gui::Label _lblDensity;
     gui::Slider _slDensity;
 
@@ -41,7 +52,11 @@ private:
     gui::NumericEdit _edCols;
 
     gui::CheckBox _chkDiagonal;
+    gui::Label _lblCorners;
+    gui::ComboBox _cmbCorners;
+    gui::CheckBox _chkJumpTable;
     gui::CheckBox _chkGuarantee;
+    gui::CheckBox _chkComponents;
 
     gui::Label _lblVisitedColor;
     gui::ColorPicker _visitedColor;
@@ -61,13 +76,21 @@ private:
     FnUpdateUI _fnUpdateUI;
     FnStatus _fnStatus;
 
-    // Animation (UI thread)
+    // Animation: the search runs on the model's worker thread at the chosen
+    // speed; one timer tick per frame repaints what it published
     gui::Timer _timer;
     bool _animating = false;
 
     int _lastRows = 25;
     int _lastCols = 25;
-    const int _maxDelayMS = 2000;
+
+    static constexpr float cFrameSec = 1.0f / 60.0f;
+    // Speed slider: 0..cSpeedMax maps logarithmically to 1..10^cSpeedDecades
+    // steps/s; the top position runs as fast as the budget allows
+    static constexpr int cSpeedMax = 120;
+    static constexpr double cSpeedDecades = 6;
+    // Timeline slider: 0..cTimelineMax spans the recorded run
+    static constexpr int cTimelineMax = 1000;
 
     // Run bookkeeping (prevents any stale timer events from affecting a new run)
     td::UINT4 _runId = 0;
@@ -78,13 +101,25 @@ private:
     {
         if (!_fnStatus) return;
         const auto& m = _canvas.model();
-        _fnStatus(msg, m.visitedCount(), m.pathLength(), timeMS);
+        _fnStatus(msg, m.stats(), timeMS);
+    }
+
+    // The size fields follow a maze read from a file, so applying them does not resize it back
+    void syncSizeFields()
+    {
+        const auto& opt = _canvas.model().options();
+        _lastRows = opt.rows;
+        _lastCols = opt.cols;
+        _edRows.setText(std::to_string(opt.rows).c_str());
+        _edCols.setText(std::to_string(opt.cols).c_str());
     }
 
     void stopTimerInternal()
     {
         if (_timer.isRunning())
             _timer.stop();
+        if (_animating)
+            _canvas.stopAnimation();
         _animating = false;
     }
 
@@ -94,11 +129,15 @@ private:
         auto& opt = model.options();
 
         opt.algorithm = MazeModel::Algorithm(_cmbAlg.getSelectedIndex());
+        opt.openList = maze::OpenListKind(_cmbOpen.getSelectedIndex());
+        opt.heuristic = maze::HeuristicKind(_cmbHeuristic.getSelectedIndex());
         opt.diagonal = _chkDiagonal.isChecked();
+        opt.corners = maze::CornerRule(_cmbCorners.getSelectedIndex());
+        opt.jumpTable = _chkJumpTable.isChecked();
         opt.guaranteePath = _chkGuarantee.isChecked();
+        opt.showComponents = _chkComponents.isChecked();
 
-        int sliderVal = int(_slSpeed.getValue());
-        opt.sleepMS = std::max(_maxDelayMS - sliderVal, 0);
+        opt.stepsPerSec = speedFromSlider(_slSpeed.getValue());
 
         double d = _slDensity.getValue();
         opt.density = float(0.05 + (0.45 - 0.05) * (d / 100.0));
@@ -113,8 +152,8 @@ private:
         _edRows.getValue(rows);
         _edCols.getValue(cols);
 
-        rows = std::max(5, std::min(rows, 80));
-        cols = std::max(5, std::min(cols, 80));
+        rows = maze::Grid::clampDim(rows);
+        cols = maze::Grid::clampDim(cols);
 
         if (rows != _lastRows || cols != _lastCols)
         {
@@ -126,12 +165,11 @@ private:
         }
     }
 
-    void configureTimerInterval()
+    static double speedFromSlider(double val)
     {
-        int sleepMS = _canvas.model().options().sleepMS;
-        sleepMS = std::max(0, std::min(sleepMS, _maxDelayMS));
-        float interval = (sleepMS == 0) ? 0.001f : float(sleepMS) / 1000.0f;
-        _timer.setInterval(interval);
+        if (val >= cSpeedMax)
+            return 0;
+        return std::pow(10.0, cSpeedDecades * std::max(0.0, val) / cSpeedMax);
     }
 
     void onTimerTick(td::UINT4 tickRunId)
@@ -140,8 +178,14 @@ private:
         if (!_animating || tickRunId != _runId)
             return;
 
-        // One step per tick: canvas redraw happens inside
-        _canvas.stepForAnimation();
+        _canvas.syncFrame();
+
+        // An edit stopped the worker and cleared the search: search the edited maze
+        if (!_canvas.isAnimating() && !_canvas.isFinished())
+        {
+            _canvas.startAnimation(_canvas.model().options().stepsPerSec);
+            return;
+        }
 
         if (_canvas.isFinished())
         {
@@ -168,12 +212,13 @@ private:
 
         // Clear previous search so a second run doesn't carry finished state
         _canvas.clearSearch();
-
-        configureTimerInterval();
+        // the new run is shown live, so the timeline goes back to its end
+        _slTimeline.setValue(cTimelineMax);
 
         _runId++;
         _t0 = std::chrono::high_resolution_clock::now();
         _animating = true;
+        _canvas.startAnimation(_canvas.model().options().stepsPerSec);
 
         publishStatus(tr("statusRunning"));
         _timer.start();
@@ -183,45 +228,80 @@ private:
 public:
     MainView(const FnUpdateUI& fnUpdateUI, const FnStatus& fnStatus)
     : _lblAlg(tr("Algorithm"))
+    , _lblOpen(tr("lblOpenList"))
+    , _lblHeuristic(tr("lblHeuristic"))
     , _lblSpeed(tr("Speed"))
+    , _lblTimeline(tr("lblTimeline"))
     , _lblDensity(tr("Density"))
     , _lblSize(tr("Size"))
     , _edRows(td::int4)
     , _edCols(td::int4)
     , _chkDiagonal(tr("Diagonal"))
+    , _lblCorners(tr("lblCorners"))
+    , _chkJumpTable(tr("chkJumpTable"))
     , _chkGuarantee(tr("Guarantee"))
+    , _chkComponents(tr("chkComponents"))
     , _lblVisitedColor(tr("VisitedColor"))
     , _lblPathColor(tr("PathColor"))
     , _lblEdit(tr("Edit"))
-    , _gl(2, 18)
+    , _gl(2, 28)
     , _canvas(fnUpdateUI)
     , _fnUpdateUI(fnUpdateUI)
     , _fnStatus(fnStatus)
-    , _timer(this, 0.05f, false)
+    , _timer(this, cFrameSec, false)
     {
         _cmbAlg.addItem("BFS");
         _cmbAlg.addItem("Dijkstra");
         _cmbAlg.addItem("A*");
+        _cmbAlg.addItem("JPS");
+        _cmbAlg.addItem("Bi-BFS");
+        _cmbAlg.addItem("Bi-A*");
+        _cmbAlg.addItem("D* Lite");
+        _cmbAlg.addItem("HPA*");
         _cmbAlg.selectIndex(2);
 
+        _cmbOpen.addItem(tr("openBinaryHeap"));
+        _cmbOpen.addItem(tr("openQuaternaryHeap"));
+        _cmbOpen.addItem(tr("openPairingHeap"));
+        _cmbOpen.addItem(tr("openBucketQueue"));
+        _cmbOpen.selectIndex(0);
+
+        _cmbHeuristic.addItem(tr("heurAuto"));
+        _cmbHeuristic.addItem(tr("heurManhattan"));
+        _cmbHeuristic.addItem(tr("heurOctile"));
+        _cmbHeuristic.addItem(tr("heurChebyshev"));
+        _cmbHeuristic.addItem(tr("heurEuclidean"));
+        _cmbHeuristic.addItem(tr("heurLandmarks"));
+        _cmbHeuristic.selectIndex(0);
+
+        _cmbCorners.addItem(tr("cornerCut"));
+        _cmbCorners.addItem(tr("cornerNoSqueeze"));
+        _cmbCorners.addItem(tr("cornerNoCut"));
+        _cmbCorners.selectIndex(0);
+
         _cmbEdit.addItem(tr("Wall"));
         _cmbEdit.addItem(tr("Start"));
         _cmbEdit.addItem(tr("Goal"));
         _cmbEdit.selectIndex(0);
 
-        _slSpeed.setRange(0, _maxDelayMS);
-        _slSpeed.setValue(_maxDelayMS - 50);
+        _slSpeed.setRange(0, cSpeedMax);
+        _slSpeed.setValue(cSpeedMax / 4);      // ~30 steps/s
+
+        _slTimeline.setRange(0, cTimelineMax);
+        _slTimeline.setValue(cTimelineMax);
 
         _slDensity.setRange(0, 100);
         _slDensity.setValue(((0.28 - 0.05) / (0.45 - 0.05)) * 100.0);
 
-        _edRows.setMinValue(5); _edRows.setMaxValue(80);
-        _edCols.setMinValue(5); _edCols.setMaxValue(80);
+        _edRows.setMinValue(maze::Grid::cMinDim); _edRows.setMaxValue(maze::Grid::cMaxDim);
+        _edCols.setMinValue(maze::Grid::cMinDim); _edCols.setMaxValue(maze::Grid::cMaxDim);
         _edRows.setText("25");
         _edCols.setText("25");
 
         _chkDiagonal.setChecked(false);
+        _chkJumpTable.setChecked(false);
         _chkGuarantee.setChecked(true);
+        _chkComponents.setChecked(false);
 
         _visitedColor.setValue(td::ColorID::Yellow);
         _pathColor.setValue(td::ColorID::Green);
@@ -240,9 +320,42 @@ public:
             if (_fnUpdateUI) _fnUpdateUI();
         });
 
+        _cmbOpen.onChangedSelection([this](){
+            stop();
+            applyControlsToModel(false);
+            _canvas.clearSearch();
+            publishStatus(tr("Ready"));
+            if (_fnUpdateUI) _fnUpdateUI();
+        });
+
+        _cmbHeuristic.onChangedSelection([this](){
+            stop();
+            applyControlsToModel(false);
+            _canvas.clearSearch();
+            publishStatus(tr("Ready"));
+            if (_fnUpdateUI) _fnUpdateUI();
+        });
+
+        _cmbCorners.onChangedSelection([this](){
+            stop();
+            applyControlsToModel(false);
+            _canvas.clearSearch();
+            publishStatus(tr("Ready"));
+            if (_fnUpdateUI) _fnUpdateUI();
+        });
+
         _slSpeed.onChangedValue([this](){
             applyControlsToModel(false);
-            configureTimerInterval();
+            _canvas.setAnimationSpeed(_canvas.model().options().stepsPerSec);
+        });
+
+        // Scrubbing replays the recorded run; it stops a running animation
+        _slTimeline.onChangedValue([this](){
+            if (isRunning())
+                stopTimerInternal();
+            _canvas.scrubTo(_slTimeline.getValue() / cTimelineMax);
+            publishStatus(tr("statusReplay"));
+            if (_fnUpdateUI) _fnUpdateUI();
         });
 
         _slDensity.onChangedValue([this](){
@@ -274,6 +387,14 @@ public:
             if (_fnUpdateUI) _fnUpdateUI();
         });
 
+        _chkJumpTable.onClick([this](){
+            stop();
+            applyControlsToModel(false);
+            _canvas.clearSearch();
+            publishStatus(tr("Ready"));
+            if (_fnUpdateUI) _fnUpdateUI();
+        });
+
         _chkGuarantee.onClick([this](){
             stop();
             applyControlsToModel(true);
@@ -281,6 +402,12 @@ public:
             if (_fnUpdateUI) _fnUpdateUI();
         });
 
+        // Overlay only: the search keeps running
+        _chkComponents.onClick([this](){
+            applyControlsToModel(false);
+            _canvas.requestRedraw();
+        });
+
         _visitedColor.onChangedValue([this](){
             applyControlsToModel(false);
             _canvas.clearSearch();
@@ -298,10 +425,13 @@ public:
         gui::GridComposer gc(_gl);
         gc.startNewRowWithSpace(5, 0)
             << _lblAlg << _cmbAlg
+            << _lblOpen << _cmbOpen
+            << _lblHeuristic << _cmbHeuristic
             << _lblSpeed << _slSpeed
+            << _lblTimeline << _slTimeline
             << _lblDensity << _slDensity
             << _lblSize << _edRows << _edCols
-            << _chkDiagonal << _chkGuarantee
+            << _chkDiagonal << _lblCorners << _cmbCorners << _chkJumpTable << _chkGuarantee << _chkComponents
             << _lblVisitedColor << _visitedColor
             << _lblPathColor << _pathColor
             << _lblEdit << _cmbEdit;
@@ -340,6 +470,7 @@ public:
     {
         stop();
         applyControlsToModel(false);
+        _slTimeline.setValue(cTimelineMax);     // stepping leaves replay
 
         auto t0 = std::chrono::high_resolution_clock::now();
         _canvas.stepOnce();
@@ -368,6 +499,45 @@ public:
         if (_fnUpdateUI) _fnUpdateUI();
     }
 
+    // Binary maze file in the working directory
+    static constexpr const char* cMazeFile = "maze.mzb";
+
+    void saveMaze()
+    {
+        stop();
+        publishStatus(_canvas.saveMaze(cMazeFile) ? tr("statusSaved") : tr("statusSaveFailed"));
+        if (_fnUpdateUI) _fnUpdateUI();
+    }
+
+    void loadMaze()
+    {
+        stop();
+        if (_canvas.loadMaze(cMazeFile))
+        {
+            syncSizeFields();
+            publishStatus(tr("statusLoaded"));
+        }
+        else
+            publishStatus(tr("statusLoadFailed"));
+        if (_fnUpdateUI) _fnUpdateUI();
+    }
+
+    // MovingAI benchmark map in the working directory
+    static constexpr const char* cMapFile = "maze.map";
+
+    void importMap()
+    {
+        stop();
+        if (_canvas.importMap(cMapFile))
+        {
+            syncSizeFields();
+            publishStatus(tr("statusImported"));
+        }
+        else
+            publishStatus(tr("statusImportFailed"));
+        if (_fnUpdateUI) _fnUpdateUI();
+    }
+
     void setFocusToCanvas()
     {
         _canvas.setFocus();
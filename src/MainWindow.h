@@ -22,7 +22,7 @@ class MainWindow : public gui::Window
     StatusBar _statusBar;
 
     std::function<void()> _fnUpdateUI;
-    std::function<void(const td::String&, int, int, int)> _fnStatus;
+    MainView::FnStatus _fnStatus;
 
     MainView _view;
 
@@ -59,11 +59,10 @@ protected:
         }
     }
 
-    void setStatus(const td::String& msg, int visited, int pathLen, int timeMS)
+    void setStatus(const td::String& msg, const maze::SearchStats& stats, int timeMS)
     {
         _statusBar.setMessage(msg);
-        _statusBar.setVisited(visited);
-        _statusBar.setPath(pathLen);
+        _statusBar.setStats(stats);
         _statusBar.setTimeMS(timeMS);
     }
 
@@ -75,6 +74,9 @@ protected:
             case cMenuMaze:
                 if (actionID == cActionNew) { _view.newMaze(); return true; }
                 if (actionID == cActionStep){ _view.step();    return true; }
+                if (actionID == cActionSave){ _view.saveMaze(); return true; }
+                if (actionID == cActionLoad){ _view.loadMaze(); return true; }
+                if (actionID == cActionImport){ _view.importMap(); return true; }
                 break;
             case cMenuAnim:
                 if (actionID == cActionStartStop){ _view.startStop(); return true; }
@@ -94,7 +96,7 @@ public:
     , _imgStep(":step")
     , _toolBar(&_imgStart, &_imgRegen, &_imgStep)
     , _fnUpdateUI(std::bind(&MainWindow::updateMenuAndTB, this))
-    , _fnStatus(std::bind(&MainWindow::setStatus, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4))
+    , _fnStatus(std::bind(&MainWindow::setStatus, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3))
     , _view(_fnUpdateUI, _fnStatus)
     {
         setTitle(tr("Maze"));
@@ -1,6 +1,8 @@
 #pragma once
 #include <gui/Canvas.h>
 #include <functional>
+#include <algorithm>
+#include <string>
 #include "MazeModel.h"
 
 class MazeCanvas : public gui::Canvas
@@ -24,12 +26,21 @@ protected:
     void onResize(const gui::Size& newSize) override
     {
         _model.setViewSize(newSize);
-        reDraw();
+        refresh();
     }
 
-    void onDraw(const gui::Rect&) override
+    void onDraw(const gui::Rect& rDraw) override
     {
-        _model.draw();
+        _model.prepareDraw();
+        _model.draw(rDraw);
+    }
+
+    // Invalidates only the region the model reports as changed
+    void refresh()
+    {
+        gui::Rect rc;
+        if (_model.takeDirtyRect(rc))
+            reDraw(rc);
     }
 
     void onPrimaryButtonReleased(const gui::InputDevice& inputDevice) override
@@ -43,12 +54,29 @@ protected:
             case EditMode::SetStart:   _model.setStart(cell);   break;
             case EditMode::SetGoal:    _model.setGoal(cell);    break;
         }
-        reDraw();
+        refresh();
+    }
+
+    // Pinch / ctrl+wheel zooms around the cursor
+    bool onZoom(const gui::InputDevice& inputDevice) override
+    {
+        _model.zoomAt(inputDevice.getModelPoint(), inputDevice.getScale());
+        refresh();
+        return true;
+    }
+
+    // Wheel / two-finger scroll pans the zoomed grid
+    bool onScroll(const gui::InputDevice& inputDevice) override
+    {
+        const gui::Point d = inputDevice.getScrollDelta();
+        _model.panBy(-d.x, -d.y);
+        refresh();
+        return true;
     }
 
 public:
     MazeCanvas(const std::function<void()>& fnUpdateUI)
-    : gui::Canvas({gui::InputDevice::Event::Keyboard, gui::InputDevice::Event::PrimaryClicks})
+    : gui::Canvas({gui::InputDevice::Event::Keyboard, gui::InputDevice::Event::PrimaryClicks, gui::InputDevice::Event::Zoom})
     , _fnUpdateUI(fnUpdateUI)
     {
         setPreferredFrameRateRange(60, 60);
@@ -63,37 +91,84 @@ public:
     void newMaze()
     {
         _model.generate();
-        reDraw();
+        refresh();
+    }
+
+    bool saveMaze(const std::string& path) { return _model.saveFile(path); }
+
+    bool loadMaze(const std::string& path)
+    {
+        if (!_model.loadFile(path))
+            return false;
+        refresh();
+        return true;
+    }
+
+    bool importMap(const std::string& path)
+    {
+        if (!_model.importMap(path))
+            return false;
+        refresh();
+        return true;
     }
 
     // One search step (used by Step button)
     void stepOnce()
     {
         _model.step();
-        reDraw();
+        refresh();
     }
 
-    // Start/stop is handled by worker thread in MainView (for animation),
-    // but we expose step() for it.
-    bool stepForAnimation()
+    // Animation runs on the model's worker thread; the canvas only shows it
+    void startAnimation(double stepsPerSec)
     {
-        bool changed = _model.step();
-        reDraw();
-        return changed;
+        _model.startAnimation(stepsPerSec);
+        refresh();
+    }
+
+    void stopAnimation()
+    {
+        _model.stopAnimation();
+        refresh();
+    }
+
+    void setAnimationSpeed(double stepsPerSec) { _model.setAnimationSpeed(stepsPerSec); }
+
+    // Once per frame: repaints what the worker published since the last frame
+    void syncFrame() { refresh(); }
+
+    // Replays the recorded run at the given position (0 = start, 1 = end)
+    void scrubTo(double fraction)
+    {
+        const std::size_t steps = _model.traceSteps();
+        if (steps == 0)
+            return;
+        fraction = std::max(0.0, std::min(1.0, fraction));
+        _model.scrubTo(std::size_t(fraction * double(steps - 1) + 0.5));
+        refresh();
     }
 
     void clearSearch()
     {
         _model.clearSearchVisualization();
-        reDraw();
+        refresh();
+    }
+
+    // Whole maze fitted into the view again
+    void resetView()
+    {
+        _model.resetView();
+        refresh();
     }
 
     void requestRedraw()
     {
-        reDraw();
+        _model.markAllDirty();
+        refresh();
     }
 
     bool isRunning() const { return _model.isRunning(); }
+    bool isAnimating() const { return _model.isAnimating(); }
     bool isFinished() const { return _model.isFinished(); }
     bool isSolved() const { return _model.isSolved(); }
 };
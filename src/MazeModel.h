@@ -1,99 +1,355 @@
 #pragma once
-#include <vector>
-#include <queue>
-#include <random>
-#include <limits>
 #include <algorithm>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
 #include <cmath>
-#include <cstdint>
 
 #include <gui/Shape.h>
 #include <gui/Types.h>
 #include <td/ColorID.h>
 
+#include "core/Grid.h"
+#include "core/Generator.h"
+#include "core/SearchEngine.h"
+#include "core/SearchWorker.h"
+#include "core/StateMirror.h"
+#include "core/CellRaster.h"
+#include "core/Connectivity.h"
+#include "core/MazeFile.h"
+#include "core/MovingAI.h"
+#include "GridImage.h"
+
+// GUI front-end over the headless core: owns the grid and the search engine
+// and adds view geometry, colors and drawing.
+//
+// Drawing is incremental: the engine logs every cell whose state changes, the
+// model adds cells it edits itself, and takeDirtyRect() turns that into the
+// view region to repaint. Only resize, regenerate and search resets repaint
+// the whole view.
+//
+// Cells are rendered through a CellRaster covering only the visible window of
+// cells, shown with a single scaled image draw; only changed texels are
+// rewritten and uploaded. The view can be zoomed and panned; when cells get
+// smaller than a pixel, one texel covers a block of cells (level of detail),
+// so render cost follows the visible area, not the maze size.
+//
+// Animated searches run on a SearchWorker thread. The view never reads the
+// engine while the worker owns it: cells are drawn from a StateMirror that is
+// fed with the worker's change events once per frame (and with the engine's
+// change log when stepping on the UI thread). Every edit stops the worker
+// first, since the worker reads the grid.
+//
+// Every run is recorded as a SearchTrace; scrubTo() replays any recorded step
+// into the mirror without searching again.
 class MazeModel
 {
 public:
-    struct Cell { int r=0,c=0; };
-
-    enum class Algorithm : int
-    {
-        BFS = 0,
-        Dijkstra = 1,
-        AStar = 2
-    };
+    using Cell = maze::Cell;
+    using Algorithm = maze::Algorithm;
 
     struct Options
     {
         Algorithm algorithm = Algorithm::AStar;
+        maze::OpenListKind openList = maze::OpenListKind::BinaryHeap;
         bool diagonal = false;
+        maze::CornerRule corners = maze::CornerRule::Cut;         // diagonal moves past walls
+        maze::HeuristicKind heuristic = maze::HeuristicKind::Auto;
+        bool jumpTable = false;           // JPS+ (JPS only)
         bool guaranteePath = true;
-        int sleepMS = 50;                 // for animation thread
+        bool showComponents = false;      // tint free cells by connected component
+        double stepsPerSec = 20;          // animation speed, 0 = as fast as possible
         float density = 0.28f;            // wall probability
         int rows = 25;
         int cols = 25;
         td::ColorID visitedColor = td::ColorID::Yellow;
         td::ColorID frontierColor = td::ColorID::Cyan;
         td::ColorID pathColor = td::ColorID::Green;
+        td::ColorID backVisitedColor = td::ColorID::Orange;     // backward side of bidirectional searches
+        td::ColorID backFrontierColor = td::ColorID::Magenta;
     };
 
 private:
     Options _opt;
     gui::Size _viewSize{900,900};
 
-    std::vector<unsigned char> _grid;   // 0 free, 1 wall
-    std::vector<uint8_t> _state;        // 0 none, 1 visited(closed), 2 frontier(open), 3 path
-    std::vector<Cell> _path;
+    maze::Grid _grid;
+    unsigned _seed = 0;                 // generator seed of the maze, 0 if unknown
+    maze::ConnectivityIndex _components;  // read by the worker's engine, so declared before it
+    maze::SearchWorker _worker;         // owns the engine; declared after _grid, so stopped before it goes away
+    maze::StateMirror _mirror;          // what the view shows
+    std::size_t _changes = 0;           // cell changes queued since the last frame
+
+    maze::TracePlayer _player;
+    bool _replaying = false;            // the mirror shows a recorded step, not the live search
 
-    Cell _start{0,0};
-    Cell _goal{24,24};
+    // Cells to repaint on the next frame: inclusive range, empty if r0 > r1
+    bool _dirtyAll = true;
+    int _dirtyR0 = 1, _dirtyC0 = 1, _dirtyR1 = 0, _dirtyC1 = 0;
+    std::vector<Cell> _edited;          // cells changed by edits, not by the search
 
-    // Search state (for step-by-step)
-    bool _running = false;
-    bool _finished = false;
-    bool _solved = false;
+    maze::CellRaster _raster;
+    GridImage _image;
+    gui::Shape _gridLines;
+    bool _hasGridLines = false;
 
-    // For BFS/Dijkstra/A*
-    struct PQNode { int f,g,idx; };
-    struct PQCmp { bool operator()(const PQNode& a, const PQNode& b) const { return a.f > b.f; } };
+    // View transform: zoom 1 fits the whole grid, pan shifts the grid origin
+    double _zoom = 1.0;
+    gui::Point _pan{0, 0};
+
+    struct Layout
+    {
+        gui::CoordType cell;    // cell size
+        gui::CoordType ox;      // grid origin
+        gui::CoordType oy;
+    };
+
+    // Visible cells (inclusive) and the level of detail to draw them with
+    struct Window
+    {
+        int r0, c0, r1, c1;
+        int lod;                // cells per texel along each axis
+    };
 
-    std::priority_queue<PQNode, std::vector<PQNode>, PQCmp> _pq;
-    std::queue<int> _q;
-    std::vector<int> _gScore;
-    std::vector<int> _parent;
+    // Extra margin around dirty cells: start/goal outlines spill into neighbors
+    static constexpr gui::CoordType cMarkSpill = 3;
+    // Grid lines are drawn only for cells at least this large (pixels)
+    static constexpr gui::CoordType cGridLineMinCell = 6;
+    // Zoom stops once cells reach this size (pixels)
+    static constexpr gui::CoordType cMaxCell = 64;
 
 private:
-    static int id(int r,int c,int cols){ return r*cols + c; }
-    int N() const { return _opt.rows * _opt.cols; }
+    // Cell size at zoom 1; 0 until the canvas has a size (or while it has none)
+    gui::CoordType fitCell() const
+    {
+        return std::min(_viewSize.width / _opt.cols, _viewSize.height / _opt.rows);
+    }
+
+    // Centers an axis that fits into the view, otherwise keeps the view covered
+    static gui::CoordType clampOrigin(gui::CoordType origin, gui::CoordType extent, gui::CoordType view)
+    {
+        if (extent <= view)
+            return (view - extent) / 2;
+        return std::min<gui::CoordType>(0, std::max(view - extent, origin));
+    }
+
+    Layout layout() const
+    {
+        const gui::CoordType fit = fitCell();
+        if (fit <= 0)
+            return {0, 0, 0};
+        const int R=_opt.rows, C=_opt.cols;
+        gui::CoordType w=_viewSize.width, h=_viewSize.height;
+        // whole pixels while cells are at least one pixel; the raster scales below that
+        gui::CoordType cell = fit * _zoom;
+        if (cell >= 1) cell = std::floor(cell);
+        const gui::CoordType gw = cell * C, gh = cell * R;
+        return {cell, clampOrigin((w - gw) / 2 + _pan.x, gw, w), clampOrigin((h - gh) / 2 + _pan.y, gh, h)};
+    }
 
-    int heuristic(int r,int c) const
+    // Stores the pan that reproduces the given origin under the current zoom
+    void setOrigin(const Layout& lay)
     {
-        // Manhattan works well for 4-neighborhood, still ok for diagonal as admissible if scaled
-        return std::abs(_goal.r-r) + std::abs(_goal.c-c);
+        _pan.x = lay.ox - (_viewSize.width - lay.cell * _opt.cols) / 2;
+        _pan.y = lay.oy - (_viewSize.height - lay.cell * _opt.rows) / 2;
     }
 
-    void rebuildPathFrom(int goalIdx)
+    Window visibleWindow(const Layout& lay) const
     {
-        _path.clear();
-        int t = goalIdx;
-        while (t != -1)
+        if (lay.cell <= 0)
+            return {0, 0, -1, -1, 1};   // no view: nothing visible
+        const int R=_opt.rows, C=_opt.cols;
+        Window win;
+        win.c0 = std::max(0, int(std::floor(-lay.ox / lay.cell)));
+        win.r0 = std::max(0, int(std::floor(-lay.oy / lay.cell)));
+        win.c1 = std::min(C - 1, int(std::ceil((_viewSize.width - lay.ox) / lay.cell)) - 1);
+        win.r1 = std::min(R - 1, int(std::ceil((_viewSize.height - lay.oy) / lay.cell)) - 1);
+        win.lod = 1;
+        while (win.lod * lay.cell < 1)
+            win.lod *= 2;
+        return win;
+    }
+
+    static gui::Rect cellRect(const Layout& lay, int r, int c)
+    {
+        return gui::Rect(gui::Point(lay.ox + c*lay.cell, lay.oy + r*lay.cell), gui::Size(lay.cell, lay.cell));
+    }
+
+    void markDirty(Cell cell)
+    {
+        _edited.push_back(cell);
+        extendDirty(cell);
+    }
+
+    void extendDirty(Cell cell)
+    {
+        if (_dirtyR0 > _dirtyR1)
         {
-            _path.push_back({t / _opt.cols, t % _opt.cols});
-            t = _parent[t];
+            _dirtyR0 = _dirtyR1 = cell.r;
+            _dirtyC0 = _dirtyC1 = cell.c;
+            return;
         }
-        std::reverse(_path.begin(), _path.end());
+        _dirtyR0 = std::min(_dirtyR0, cell.r);
+        _dirtyR1 = std::max(_dirtyR1, cell.r);
+        _dirtyC0 = std::min(_dirtyC0, cell.c);
+        _dirtyC1 = std::max(_dirtyC1, cell.c);
+    }
 
-        // mark state as path (leave visited/frontier for visualization)
-        for (const auto& p : _path)
+    // Returns true if any overlay color changed
+    bool syncPalette()
+    {
+        bool changed = false;
+        changed |= _raster.setPalette(maze::Shade::Visited, GridImage::rgbaOf(_opt.visitedColor));
+        changed |= _raster.setPalette(maze::Shade::Frontier, GridImage::rgbaOf(_opt.frontierColor));
+        changed |= _raster.setPalette(maze::Shade::Path, GridImage::rgbaOf(_opt.pathColor));
+        changed |= _raster.setPalette(maze::Shade::BackVisited, GridImage::rgbaOf(_opt.backVisitedColor));
+        changed |= _raster.setPalette(maze::Shade::BackFrontier, GridImage::rgbaOf(_opt.backFrontierColor));
+        return changed;
+    }
+
+    // One batch of segments (point pairs) along the borders of the visible cells
+    void rebuildGridLines(const Layout& lay, const Window& win)
+    {
+        _hasGridLines = lay.cell >= cGridLineMinCell && win.r0 <= win.r1 && win.c0 <= win.c1;
+        if (!_hasGridLines)
+            return;
+
+        const gui::CoordType x0 = lay.ox + win.c0 * lay.cell, x1 = lay.ox + (win.c1 + 1) * lay.cell;
+        const gui::CoordType y0 = lay.oy + win.r0 * lay.cell, y1 = lay.oy + (win.r1 + 1) * lay.cell;
+        std::vector<gui::Point> pts;
+        pts.reserve(std::size_t(win.r1 - win.r0 + win.c1 - win.c0 + 4) * 2);
+        for (int r = win.r0; r <= win.r1 + 1; r++)
+        {
+            pts.emplace_back(x0, lay.oy + r * lay.cell);
+            pts.emplace_back(x1, lay.oy + r * lay.cell);
+        }
+        for (int c = win.c0; c <= win.c1 + 1; c++)
         {
-            int i = id(p.r, p.c, _opt.cols);
-            _state[i] = 3;
+            pts.emplace_back(lay.ox + c * lay.cell, y0);
+            pts.emplace_back(lay.ox + c * lay.cell, y1);
         }
+        _gridLines.createLines(pts.data(), pts.size());
+    }
+
+    // Only while the worker is idle
+    maze::SearchEngine& engine() { return _worker.engine(); }
+    const maze::SearchEngine& engine() const { return _worker.engine(); }
+
+    void noteChange(std::size_t i)
+    {
+        const Cell cell = _grid.cellAt(i);
+        _raster.updateCell(cell.r, cell.c);
+        extendDirty(cell);
+        _changes++;
+    }
+
+    // Applies the events the worker published so far to the mirror
+    void drainEvents()
+    {
+        _worker.drain([this](const maze::CellEvent& ev)
+        {
+            _mirror.set(ev.cell, ev.state, ev.backward);
+            noteChange(ev.cell);
+        });
+    }
+
+    // Applies the engine's own change log (idle worker only)
+    void syncEngineChanges()
+    {
+        maze::SearchEngine& e = engine();
+        if (e.changedAll())
+        {
+            _mirror.clear();
+            _dirtyAll = true;
+        }
+        e.forEachChange([&](std::size_t i)
+        {
+            _mirror.set(i, e.state(i), e.isBackward(i));
+            noteChange(i);
+        });
+        e.clearChanges();
+    }
+
+    // Brings the mirror up to date; joins a worker that has finished
+    void pumpSearch()
+    {
+        if (_worker.busy())
+        {
+            // read before draining: once done, all of its events are in the ring
+            const bool done = _worker.done();
+            drainEvents();
+            if (done)
+                _worker.finish();
+        }
+        if (!_worker.busy())
+            syncEngineChanges();
+    }
+
+    // Cancels a background search; the engine keeps the state it reached
+    void stopWorker()
+    {
+        if (!_worker.busy())
+            return;
+        _worker.stop();
+        drainEvents();
+    }
+
+    // Back to the live search by replaying up to the last recorded step
+    void leaveReplay()
+    {
+        if (!_replaying)
+            return;
+        _replaying = false;
+        if (_player.seek(std::size_t(-1), _mirror, [this](std::size_t i) { noteChange(i); }))
+            _dirtyAll = true;
+    }
+
+    // Leaves replay when the live states are about to be reset anyway
+    void dropReplay()
+    {
+        if (!_replaying)
+            return;
+        _replaying = false;
+        _mirror.clear();
+        _dirtyAll = true;
+    }
+
+    // Rebuilds the connectivity index if the grid or the movement model
+    // changed other than through toggleWall()
+    void syncConnectivity()
+    {
+        if (!_worker.busy() && !_components.matches(_grid, _opt.diagonal, _opt.corners))
+            _components.build(_grid, _opt.diagonal, _opt.corners);
+    }
+
+    void syncSearchOptions()
+    {
+        syncConnectivity();
+        auto& so = engine().options();
+        so.algorithm = _opt.algorithm;
+        so.diagonal = _opt.diagonal;
+        so.corners = _opt.corners;
+        so.heuristic = _opt.heuristic;
+        so.openList = _opt.openList;
+        so.jumpTable = _opt.jumpTable;
+    }
+
+    // The grid got new walls and a new size from a file
+    void gridReplaced()
+    {
+        _opt.rows = _grid.rows();
+        _opt.cols = _grid.cols();
+        _mirror.resize(_grid.size());
+        engine().attach(_grid);
+        resetView();
     }
 
 public:
     MazeModel()
     {
+        engine().recordTrace(true);
+        engine().useConnectivity(&_components);
         applySize(_opt.rows, _opt.cols);
         generate();
     }
@@ -102,34 +358,144 @@ public:
     Options& options() { return _opt; }
     const Options& options() const { return _opt; }
 
+    const maze::Grid& grid() const { return _grid; }
     void applySize(int rows, int cols)
     {
-        _opt.rows = std::max(5, std::min(rows, 80));
-        _opt.cols = std::max(5, std::min(cols, 80));
-        _grid.assign(N(), 0);
-        _state.assign(N(), 0);
-        _gScore.assign(N(), std::numeric_limits<int>::max());
-        _parent.assign(N(), -1);
-        _start = {0,0};
-        _goal = {_opt.rows-1, _opt.cols-1};
+        stopWorker();
+        _replaying = false;
+        _opt.rows = maze::Grid::clampDim(rows);
+        _opt.cols = maze::Grid::clampDim(cols);
+        _grid.resize(_opt.rows, _opt.cols);
+        _mirror.resize(_grid.size());
+        engine().attach(_grid);
+        resetView();
     }
 
     // ----- View & editing helpers -----
-    void setViewSize(const gui::Size& s) { _viewSize = s; }
+    void setViewSize(const gui::Size& s)
+    {
+        _viewSize = s;
+        markAllDirty();
+    }
+
+    // Next frame repaints the whole view (colors changed, resize, ...)
+    void markAllDirty() { _dirtyAll = true; }
+
+    // ----- Zoom & pan -----
+    double zoom() const { return _zoom; }
+
+    // Back to the whole grid fitted into the view
+    void resetView()
+    {
+        _zoom = 1.0;
+        _pan = gui::Point(0, 0);
+        markAllDirty();
+    }
+
+    // Multiplies the zoom by factor, keeping the grid point under p in place
+    void zoomAt(const gui::Point& p, double factor)
+    {
+        const gui::CoordType fit = fitCell();
+        if (fit <= 0)
+            return;
+        const Layout before = layout();
+        const double maxZoom = std::max(1.0, double(cMaxCell / fit));
+        const double zoom = std::max(1.0, std::min(maxZoom, _zoom * factor));
+        if (zoom == _zoom)
+            return;
+
+        // grid coordinates (in cells) under the cursor
+        const double u = (p.x - before.ox) / before.cell, v = (p.y - before.oy) / before.cell;
+        _zoom = zoom;
+        Layout after = layout();
+        after.ox = p.x - u * after.cell;
+        after.oy = p.y - v * after.cell;
+        setOrigin(after);
+        setOrigin(layout());    // drop pan beyond the grid edges
+        markAllDirty();
+    }
+
+    void panBy(gui::CoordType dx, gui::CoordType dy)
+    {
+        const Layout before = layout();
+        _pan.x += dx;
+        _pan.y += dy;
+        const Layout after = layout();
+        setOrigin(after);
+        if (after.ox != before.ox || after.oy != before.oy)
+            markAllDirty();
+    }
+
+    // Collects everything that changed since the last call. Returns false if
+    // nothing needs repainting, otherwise the view region to repaint.
+    bool takeDirtyRect(gui::Rect& rect)
+    {
+        pumpSearch();
+        if (fitCell() <= 0)
+            return false;   // nothing to show; the next size change repaints everything
+
+        const Layout lay = layout();
+        const Window win = visibleWindow(lay);
+        if (_raster.setWindow(win.r0, win.c0, win.r1, win.c1, win.lod))
+            _dirtyAll = true;
+        if (_opt.showComponents)
+            syncConnectivity();
+        if (_raster.setOverlay(_opt.showComponents ? &_components : nullptr))
+            _dirtyAll = true;
+        if (syncPalette() || _changes > _raster.texelCount())
+            _dirtyAll = true;
+
+        if (_dirtyAll)
+        {
+            _raster.render(_grid, _mirror);
+            rebuildGridLines(lay, win);
+        }
+        else
+        {
+            for (const Cell& cell : _edited)
+                _raster.updateCell(cell.r, cell.c);
+            _raster.flush(_grid, _mirror);
+        }
+        _changes = 0;
+        _edited.clear();
+        _image.sync(_raster);
+
+        const bool any = _dirtyAll || _dirtyR0 <= _dirtyR1;
+        if (_dirtyAll)
+            rect = gui::Rect(gui::Point(0, 0), _viewSize);
+        else if (any)
+        {
+            // a texel covers lod cells: widen to whole texels
+            const gui::CoordType spill = cMarkSpill + win.lod * lay.cell;
+            gui::Rect a = cellRect(lay, _dirtyR0, _dirtyC0);
+            gui::Rect b = cellRect(lay, _dirtyR1, _dirtyC1);
+            rect = gui::Rect(std::max<gui::CoordType>(0, a.left - spill), std::max<gui::CoordType>(0, a.top - spill),
+                             std::min(_viewSize.width, b.right + spill), std::min(_viewSize.height, b.bottom + spill));
+        }
+
+        _dirtyAll = false;
+        _dirtyR0 = _dirtyC0 = 1;
+        _dirtyR1 = _dirtyC1 = 0;
+        return any;
+    }
+
+    // Right before drawing: a pending full rebuild (first frame) happens now
+    void prepareDraw()
+    {
+        gui::Rect rc;
+        if (_dirtyAll)
+            takeDirtyRect(rc);
+    }
 
     Cell pointToCell(const gui::Point& p) const
     {
         const int R=_opt.rows, C=_opt.cols;
-        gui::CoordType w=_viewSize.width, h=_viewSize.height;
-        gui::CoordType cell = std::floor(std::min(w / C, h / R));
-        if(cell < 6) cell = 6;
-        gui::CoordType gridW = cell * C;
-        gui::CoordType gridH = cell * R;
-        gui::CoordType ox = (w - gridW) / 2;
-        gui::CoordType oy = (h - gridH) / 2;
-
-        int c = int((p.x - ox) / cell);
-        int r = int((p.y - oy) / cell);
+        const Layout lay = layout();
+        if (lay.cell <= 0)
+            return {0, 0};
+
+        int c = int((p.x - lay.ox) / lay.cell);
+        int r = int((p.y - lay.oy) / lay.cell);
         if (r < 0) r = 0;
         if (c < 0) c = 0;
         if (r >= R) r = R-1;
@@ -139,39 +505,69 @@ public:
 
     void toggleWall(Cell cell)
     {
-        if (cell.r == _start.r && cell.c == _start.c) return;
-        if (cell.r == _goal.r && cell.c == _goal.c) return;
-        int i = id(cell.r, cell.c, _opt.cols);
-        _grid[i] = (_grid[i] == 1) ? 0 : 1;
-        clearSearchVisualization();
+        if (cell == _grid.start()) return;
+        if (cell == _grid.goal()) return;
+        stopWorker();
+        const bool replan = canReplan();
+        _grid.toggleWall(cell.r, cell.c);
+        engine().wallChanged(cell);
+        _components.wallChanged(cell);
+        markDirty(cell);
+        if (_opt.showComponents)
+            markAllDirty();     // a split or merge recolors whole components
+        if (replan)
+            replanSearch();
+        else
+            clearSearchVisualization();
     }
 
     void setStart(Cell cell)
     {
-        if (_grid[id(cell.r,cell.c,_opt.cols)] == 1) return;
-        _start = cell;
-        clearSearchVisualization();
+        if (_grid.isWall(cell)) return;
+        stopWorker();
+        const bool replan = canReplan();
+        markDirty(_grid.start());
+        markDirty(cell);
+        _grid.setStart(cell);
+        if (replan)
+            replanSearch();
+        else
+            clearSearchVisualization();
     }
 
     void setGoal(Cell cell)
     {
-        if (_grid[id(cell.r,cell.c,_opt.cols)] == 1) return;
-        _goal = cell;
+        if (_grid.isWall(cell)) return;
+        stopWorker();
+        markDirty(_grid.goal());
+        markDirty(cell);
+        _grid.setGoal(cell);
         clearSearchVisualization();
     }
 
+    // D* Lite keeps a finished search up to date after wall edits and start
+    // moves. Not after goal moves: its tree is rooted at the goal, so that
+    // would be a full search on the UI thread, and setGoal() clears instead.
+    bool canReplan() const
+    {
+        return _opt.algorithm == Algorithm::DStarLite && engine().options().algorithm == Algorithm::DStarLite && isFinished();
+    }
+
+    // Repairs the finished D* Lite search right away: after a wall edit only
+    // the cells whose costs it changed are searched again, after a start
+    // move nothing is (the costs to the goal stay valid)
+    void replanSearch()
+    {
+        dropReplay();
+        syncSearchOptions();
+        engine().run();
+    }
+
     void clearSearchVisualization()
     {
-        std::fill(_state.begin(), _state.end(), 0);
-        _path.clear();
-        _running = false;
-        _finished = false;
-        _solved = false;
-        // clear search containers
-        while(!_pq.empty()) _pq.pop();
-        while(!_q.empty()) _q.pop();
-        std::fill(_gScore.begin(), _gScore.end(), std::numeric_limits<int>::max());
-        std::fill(_parent.begin(), _parent.end(), -1);
+        stopWorker();
+        dropReplay();
+        engine().clear();
     }
 
     // ----- Generation -----
@@ -179,251 +575,179 @@ public:
     {
         clearSearchVisualization();
 
-        if(seed == 0)
-        {
-            std::random_device rd;
-            seed = rd();
-        }
-        std::mt19937 rng(seed);
-        std::uniform_real_distribution<float> u(0.f,1.f);
-
-        _grid.assign(N(), 0);
-        for(int r=0;r<_opt.rows;r++)
-            for(int c=0;c<_opt.cols;c++)
-                _grid[id(r,c,_opt.cols)] = (u(rng) < _opt.density) ? 1 : 0;
-
-        auto open=[&](int r,int c){
-            if(r>=0 && r<_opt.rows && c>=0 && c<_opt.cols)
-                _grid[id(r,c,_opt.cols)] = 0;
-        };
-
-        // keep corners open
-        for(int dr=0; dr<=1; dr++)
-            for(int dc=0; dc<=1; dc++)
-            {
-                open(0+dr,0+dc);
-                open(_opt.rows-1-dr, _opt.cols-1-dc);
-            }
-
-        if (_opt.guaranteePath)
-        {
-            // Guaranteed corridor: top row then right column (simple and robust)
-            for (int c = 0; c < _opt.cols; c++)
-                _grid[id(0, c, _opt.cols)] = 0;
-            for (int r = 0; r < _opt.rows; r++)
-                _grid[id(r, _opt.cols - 1, _opt.cols)] = 0;
-        }
-
-        _start = {0,0};
-        _goal  = {_opt.rows-1, _opt.cols-1};
+        maze::GenOptions gen;
+        gen.density = _opt.density;
+        gen.guaranteePath = _opt.guaranteePath;
+        _seed = maze::generate(_grid, gen, seed);
+        syncConnectivity();
+        markAllDirty();
     }
 
-    // ----- Search control -----
-    bool isRunning() const { return _running; }
-    bool isFinished() const { return _finished; }
-    bool isSolved() const { return _solved; }
-
-    int visitedCount() const
+    // ----- Files -----
+    // Binary maze file (maze::saveMaze) with the components index and the
+    // ALT tables, if built, so that loading it does not rebuild them
+    bool saveFile(const std::string& path)
     {
-        int c = 0;
-        for (auto s : _state) if (s == 1) c++;
-        return c;
+        stopWorker();
+        maze::MazeFileExtras extras;
+        extras.seed = _seed;
+        extras.components = &_components;
+        extras.landmarks = engine().landmarks();
+        return maze::saveMaze(path, _grid, extras);
     }
-    int pathLength() const { return (int)_path.size(); }
 
-    void beginSearch()
+    // Maps a file written by saveFile(); its walls are read from disk as the
+    // view and the searches touch them
+    bool loadFile(const std::string& path)
     {
         clearSearchVisualization();
+        maze::MazeFileInfo info;
+        auto landmarks = std::make_shared<maze::LandmarkTable>();
+        if (!maze::loadMaze(path, _grid, &info, &_components, landmarks.get()))
+            return false;
+        _seed = info.seed;
+        gridReplaced();
+        if (info.landmarks)
+            engine().useLandmarks(landmarks);
+        syncConnectivity();
+        markAllDirty();
+        return true;
+    }
 
-        int s = id(_start.r,_start.c,_opt.cols);
-        _gScore[s] = 0;
-        _parent[s] = -1;
+    // Reads a MovingAI benchmark map (maze::readMovingAIMap)
+    bool importMap(const std::string& path)
+    {
+        std::ifstream in(path);
+        if (!in)
+            return false;
+        clearSearchVisualization();
+        if (!maze::readMovingAIMap(in, _grid))
+            return false;
+        _seed = 0;
+        gridReplaced();
+        syncConnectivity();
+        markAllDirty();
+        return true;
+    }
 
-        if (_opt.algorithm == Algorithm::BFS)
-        {
-            _q.push(s);
-            _state[s] = 2; // frontier
-        }
-        else
+    // ----- Search control -----
+    // A background search counts as running until its last events are drawn
+    bool isRunning() const { return _worker.busy() || engine().isRunning(); }
+    bool isFinished() const { return !_worker.busy() && engine().isFinished(); }
+    bool isSolved() const { return !_worker.busy() && engine().isSolved(); }
+    bool isAnimating() const { return _worker.busy(); }
+
+    // Live counters (the worker's latest snapshot while it runs); safe to call
+    // on every frame. During replay the cell counts are those of the shown
+    // step, the other counters those of the whole run.
+    maze::SearchStats stats() const
+    {
+        if (_worker.busy())
+            return _worker.stats();
+        maze::SearchStats st = engine().stats();
+        if (_replaying && _player.step() + 1 < engine().trace().steps())
         {
-            int f0 = (_opt.algorithm == Algorithm::AStar) ? heuristic(_start.r,_start.c) : 0;
-            _pq.push({f0, 0, s});
-            _state[s] = 2;
+            st.visited = _mirror.count(maze::CellState::Visited);
+            st.frontier = _mirror.count(maze::CellState::Frontier);
+            st.pathLength = _mirror.count(maze::CellState::Path);
+            st.pathCost = -1;
         }
+        return st;
+    }
+    int visitedCount() const { return int(stats().visited); }
+    int pathLength() const { return int(stats().pathLength); }
 
-        _running = true;
-        _finished = false;
-        _solved = false;
+    void beginSearch()
+    {
+        stopWorker();
+        dropReplay();
+        _player.reset();
+        syncSearchOptions();
+        engine().begin();
     }
 
     // Returns: true if state changed (progress), false if already finished
     bool step()
     {
-        if (!_running)
-            beginSearch();
-
-        if (_finished)
-            return false;
+        stopWorker();
+        leaveReplay();
+        if (!engine().isRunning())
+            syncSearchOptions();
+        return engine().step();
+    }
 
-        const int R=_opt.rows, C=_opt.cols;
-        const int goalIdx = id(_goal.r,_goal.c,C);
+    // Starts a fresh search on the worker thread at stepsPerSec (0 = unlimited)
+    void startAnimation(double stepsPerSec)
+    {
+        stopWorker();
+        _replaying = false;
+        _player.reset();    // the run records a new trace
+        syncSearchOptions();
+        // the worker's begin() resets every state at once
+        _mirror.clear();
+        engine().clearChanges();
+        _dirtyAll = true;
+        _worker.start(stepsPerSec);
+    }
 
-        auto pushNeighbor = [&](int curIdx, int nr, int nc, int stepCost)
-        {
-            if (nr<0 || nr>=R || nc<0 || nc>=C) return;
-            int ni = id(nr,nc,C);
-            if (_grid[ni] == 1) return; // wall
-
-            if (_opt.algorithm == Algorithm::BFS)
-            {
-                if (_state[ni] == 0) // unvisited/unseen
-                {
-                    _state[ni] = 2; // frontier
-                    _parent[ni] = curIdx;
-                    _q.push(ni);
-                }
-            }
-            else
-            {
-                int tentative = _gScore[curIdx] + stepCost;
-                if (tentative < _gScore[ni])
-                {
-                    _gScore[ni] = tentative;
-                    _parent[ni] = curIdx;
-                    int h = (_opt.algorithm == Algorithm::AStar) ? heuristic(nr,nc) : 0;
-                    _pq.push({tentative + h, tentative, ni});
-                    if (_state[ni] != 1) // keep solved path marking later
-                        _state[ni] = 2; // frontier
-                }
-            }
-        };
+    void setAnimationSpeed(double stepsPerSec) { _worker.setRate(stepsPerSec); }
 
-        auto expandFrom = [&](int curIdx)
-        {
-            int r = curIdx / C;
-            int c = curIdx % C;
-
-            // mark closed/visited
-            if (_state[curIdx] != 3) // don't overwrite path marker
-                _state[curIdx] = 1;
-
-            // 4-neighborhood
-            pushNeighbor(curIdx, r-1, c, 1);
-            pushNeighbor(curIdx, r+1, c, 1);
-            pushNeighbor(curIdx, r, c-1, 1);
-            pushNeighbor(curIdx, r, c+1, 1);
-
-            if (_opt.diagonal)
-            {
-                // Diagonals with cost 2 (integer approx); keeps it simple
-                pushNeighbor(curIdx, r-1, c-1, 2);
-                pushNeighbor(curIdx, r-1, c+1, 2);
-                pushNeighbor(curIdx, r+1, c-1, 2);
-                pushNeighbor(curIdx, r+1, c+1, 2);
-            }
-        };
+    // Cancels the background search; it can be continued with step()
+    void stopAnimation() { stopWorker(); }
 
-        int curIdx = -1;
+    // ----- Replay -----
+    // Steps of the recorded run (0 if there is none); step 0 is the start
+    std::size_t traceSteps() const
+    {
+        if (_worker.busy() || !(engine().isRunning() || engine().isFinished()))
+            return 0;
+        return engine().trace().steps();
+    }
 
-        if (_opt.algorithm == Algorithm::BFS)
-        {
-            if (_q.empty())
-            {
-                _finished = true;
-                _running = false;
-                _solved = false;
-                return false;
-            }
-            curIdx = _q.front(); _q.pop();
-        }
-        else
-        {
-            while(!_pq.empty())
-            {
-                auto n = _pq.top(); _pq.pop();
-                // Skip outdated entries
-                if (n.g == _gScore[n.idx])
-                {
-                    curIdx = n.idx;
-                    break;
-                }
-            }
-            if (curIdx == -1)
-            {
-                _finished = true;
-                _running = false;
-                _solved = false;
-                return false;
-            }
-        }
+    bool isReplaying() const { return _replaying; }
+    std::size_t replayStep() const { return _player.step(); }
 
-        if (curIdx == goalIdx)
+    // Shows the state after the given step of the recorded run; stops a
+    // background search first
+    void scrubTo(std::size_t step)
+    {
+        stopWorker();
+        if (traceSteps() == 0)
+            return;
+        if (!_replaying)
         {
-            // reconstruct & finish
-            rebuildPathFrom(goalIdx);
-            _finished = true;
-            _running = false;
-            _solved = true;
-            return true;
+            // the mirror now follows the trace; the engine's pending changes are in it
+            engine().clearChanges();
+            _player.attach(engine().trace());
+            _replaying = true;
         }
-
-        expandFrom(curIdx);
-        return true;
+        if (_player.seek(step, _mirror, [this](std::size_t i) { noteChange(i); }))
+            _dirtyAll = true;
     }
 
     // ----- Drawing -----
-    void draw() const
+    // One scaled blit of the visible window, grid lines as one batch when
+    // cells are large enough to show them, then the start/goal outlines. The
+    // canvas clips to the invalidated region.
+    void draw(const gui::Rect& /*clip*/) const
     {
         const int R=_opt.rows, C=_opt.cols;
-        if(R<=0 || C<=0) return;
-
-        gui::CoordType w=_viewSize.width;
-        gui::CoordType h=_viewSize.height;
-
-        gui::CoordType cell = std::floor(std::min(w / C, h / R));
-        if(cell < 6) cell = 6;
+        if(R<=0 || C<=0 || fitCell() <= 0) return;
 
-        gui::CoordType gridW = cell * C;
-        gui::CoordType gridH = cell * R;
-        gui::CoordType ox = (w - gridW) / 2;
-        gui::CoordType oy = (h - gridH) / 2;
+        const Layout lay = layout();
+        const gui::CoordType texel = _raster.lod() * lay.cell;
+        _image.draw(gui::Rect(gui::Point(lay.ox + _raster.firstCol() * lay.cell, lay.oy + _raster.firstRow() * lay.cell),
+                              gui::Size(_raster.texCols() * texel, _raster.texRows() * texel)));
 
-        for(int r=0;r<R;r++)
-        {
-            for(int c=0;c<C;c++)
-            {
-                int i = id(r,c,C);
-                gui::CoordType x=ox+c*cell;
-                gui::CoordType y=oy+r*cell;
-                gui::Rect rc(gui::Point(x,y), gui::Size(cell,cell));
-
-                // base: free cell fill
-                td::ColorID fill = td::ColorID::White;
-                if (_grid[i] == 1) fill = td::ColorID::Black;
-
-                // overlays for search visualization
-                if (_grid[i] == 0)
-                {
-                    if (_state[i] == 2) fill = _opt.frontierColor;     // frontier
-                    else if (_state[i] == 1) fill = _opt.visitedColor; // visited
-                    else if (_state[i] == 3) fill = _opt.pathColor;    // path
-                }
-
-                gui::Shape::drawRect(rc, fill);
-                // subtle grid
-                gui::Shape::drawRect(rc, td::ColorID::DimGray, 0.8f);
-            }
-        }
+        if (_hasGridLines)
+            _gridLines.drawWire(td::ColorID::DimGray, 0.8f);
 
         auto mark=[&](Cell p, td::ColorID col, float thickness)
         {
-            gui::CoordType x=ox+p.c*cell;
-            gui::CoordType y=oy+p.r*cell;
-            gui::Rect rc(gui::Point(x,y), gui::Size(cell,cell));
-            gui::Shape::drawRect(rc, col, thickness);
+            gui::Shape::drawRect(cellRect(lay, p.r, p.c), col, thickness);
         };
 
-        mark(_start, td::ColorID::Blue, 4.0f);
-        mark(_goal, td::ColorID::Red, 4.0f);
+        mark(_grid.start(), td::ColorID::Blue, 4.0f);
+        mark(_grid.goal(), td::ColorID::Red, 4.0f);
     }
 };
@@ -16,6 +16,9 @@ class MenuBar : public gui::MenuBar
         auto& mazeItems = _subMaze.getItems();
         mazeItems[0].initAsActionItem(tr("regen"), cActionNew);
         mazeItems[1].initAsActionItem(tr("step"),  cActionStep);
+        mazeItems[2].initAsActionItem(tr("saveMaze"), cActionSave);
+        mazeItems[3].initAsActionItem(tr("loadMaze"), cActionLoad);
+        mazeItems[4].initAsActionItem(tr("importMap"), cActionImport);
 
         auto& animItems = _subAnim.getItems();
         // checkable start/stop
@@ -31,7 +34,7 @@ public:
     MenuBar()
     : gui::MenuBar(3)
     , _subApp(cMenuApp, tr("App"), 1)
-    , _subMaze(cMenuMaze, tr("Maze"), 2)
+    , _subMaze(cMenuMaze, tr("Maze"), 5)
     , _subAnim(cMenuAnim, "Run", 1)
     {
         populate();
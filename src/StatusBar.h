@@ -3,25 +3,48 @@
 #include <gui/Label.h>
 #include <gui/HorizontalLayout.h>
 #include <gui/Font.h>
+#include "core/SearchEngine.h"
 
 class StatusBar : public gui::StatusBar
 {
     gui::Label _lblMsg;
     gui::Label _lblVisitedT;
     gui::Label _lblVisited;
+    gui::Label _lblFrontierT;
+    gui::Label _lblFrontier;
+    gui::Label _lblPeakT;
+    gui::Label _lblPeak;
+    gui::Label _lblStaleT;
+    gui::Label _lblStale;
     gui::Label _lblPathT;
     gui::Label _lblPath;
+    gui::Label _lblCostT;
+    gui::Label _lblCost;
     gui::Label _lblTimeT;
     gui::Label _lblTime;
 
+    static void setCount(gui::Label& lbl, unsigned long long v)
+    {
+        td::String s; s.format("%llu", v);
+        lbl.setTitle(s);
+    }
+
 public:
     StatusBar()
-    : gui::StatusBar(14)
+    : gui::StatusBar(22)     // 15 labels + 7 spaces
     , _lblMsg(tr("statusReady"))
     , _lblVisitedT("Visited:")
     , _lblVisited("0")
+    , _lblFrontierT("Frontier:")
+    , _lblFrontier("0")
+    , _lblPeakT("Peak open:")
+    , _lblPeak("0")
+    , _lblStaleT("Stale:")
+    , _lblStale("0")
     , _lblPathT("Path:")
     , _lblPath("0")
+    , _lblCostT("Cost:")
+    , _lblCost("-")
     , _lblTimeT("Time:")
     , _lblTime("0 ms")
     {
@@ -35,8 +58,16 @@ public:
         _layout.appendSpace(10);
         _layout << _lblVisitedT << _lblVisited;
         _layout.appendSpace(10);
+        _layout << _lblFrontierT << _lblFrontier;
+        _layout.appendSpace(10);
+        _layout << _lblPeakT << _lblPeak;
+        _layout.appendSpace(10);
+        _layout << _lblStaleT << _lblStale;
+        _layout.appendSpace(10);
         _layout << _lblPathT << _lblPath;
         _layout.appendSpace(10);
+        _layout << _lblCostT << _lblCost;
+        _layout.appendSpace(10);
         _layout << _lblTimeT << _lblTime;
 
         setLayout(&_layout);
@@ -53,6 +84,23 @@ public:
         td::String s; s.format("%d", p);
         _lblPath.setTitle(s);
     }
+    // cost in fixed-point units (tenths of a cell), shown in cells
+    void setCost(long long cost)
+    {
+        td::String s;
+        if (cost < 0) s = "-";
+        else s.format("%.1f", cost / maze::cCostScale);
+        _lblCost.setTitle(s);
+    }
+    void setStats(const maze::SearchStats& st)
+    {
+        setVisited(int(st.visited));
+        setCount(_lblFrontier, st.frontier);
+        setCount(_lblPeak, st.peakOpen);
+        setCount(_lblStale, st.stalePops);
+        setPath(int(st.pathLength));
+        setCost(st.pathCost);
+    }
     void setTimeMS(int ms)
     {
         td::String s; s.format("%d ms", ms);
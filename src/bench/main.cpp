@@ -0,0 +1,439 @@
+// Microbenchmarks of the core the GUI runs on: maze generation, clearing a
+// search, full searches per algorithm, the visited counter and the frame
+// pipeline behind MazeModel::draw() (state mirror and cell raster; the final
+// image blit is left out, as if drawn into a null painter). Results can be
+// written as CSV and compared with an earlier run.
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../core/Grid.h"
+#include "../core/Generator.h"
+#include "../core/SearchEngine.h"
+#include "../core/StateMirror.h"
+#include "../core/CellRaster.h"
+
+namespace
+{
+
+// The GUI fits the whole maze into its canvas; a typical canvas size
+constexpr double cViewWidth = 1280;
+constexpr double cViewHeight = 800;
+// Shorter operations are run again until one sample takes this long, and averaged
+constexpr double cMinSampleNS = 5e6;
+// visitedCount() is too fast to time one call at a time
+constexpr int cCountCalls = 1000000;
+// Default for --floor: slowdowns of one run below this are never flagged
+constexpr double cNoiseFloorNS = 5e3;
+
+struct AlgorithmEntry
+{
+    maze::Algorithm alg;
+    const char* name;       // CLI name, also used in the bench names
+};
+
+const AlgorithmEntry cAlgorithms[] = {
+    {maze::Algorithm::BFS, "bfs"},
+    {maze::Algorithm::Dijkstra, "dijkstra"},
+    {maze::Algorithm::AStar, "astar"},
+    {maze::Algorithm::JPS, "jps"},
+    {maze::Algorithm::BidirectionalBFS, "bibfs"},
+    {maze::Algorithm::BidirectionalAStar, "biastar"},
+    {maze::Algorithm::DStarLite, "dstar"},
+    {maze::Algorithm::HPAStar, "hpa"},
+};
+
+struct GridSize
+{
+    int rows;
+    int cols;
+};
+
+struct BenchOptions
+{
+    std::vector<GridSize> sizes{{128, 128}, {512, 512}, {2048, 2048}};
+    std::vector<float> densities{0.10f, 0.28f, 0.40f};
+    std::vector<AlgorithmEntry> algorithms{std::begin(cAlgorithms), std::end(cAlgorithms)};
+    unsigned seed = 1;
+    int repeat = 9;
+    double tolerance = 10.0;    // % slower than the baseline that counts as a regression
+    double floorNS = cNoiseFloorNS;
+    std::string csvPath;
+    std::string comparePath;
+};
+
+// One operation measured at one grid size and density
+struct Result
+{
+    std::string bench;
+    int rows = 0;
+    int cols = 0;
+    float density = 0;
+    int reps = 0;
+    double medianNS = 0;
+    double minNS = 0;
+    unsigned long long items = 0;   // work of one run: cells, expansions, texels, ...
+    int calls = 1;                  // calls per run when the times are per call (not in the CSV)
+};
+
+void usage(const char* exe)
+{
+    std::fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --sizes LIST           grid sizes, N or RxC, comma separated (default 128,512,2048)\n"
+        "  --densities LIST       wall densities, comma separated (default 0.1,0.28,0.4)\n"
+        "  --alg LIST             searches to time: bfs, dijkstra, astar, jps, bibfs,\n"
+        "                         biastar, dstar, hpa, comma separated, or all (default)\n"
+        "  --seed S               generator seed (default 1; keep it fixed to compare runs)\n"
+        "  --repeat K             runs per measurement; the median is reported (default 9)\n"
+        "  --csv FILE             write the results as CSV\n"
+        "  --compare FILE         compare with the CSV of an earlier run; exit code 1 if\n"
+        "                         a fastest run is slower by more than the tolerance\n"
+        "  --tolerance PCT        allowed slowdown for --compare (default 10)\n"
+        "  --floor US             slowdowns of one run below this are noise (default 5)\n", exe);
+}
+
+std::vector<std::string> splitList(const char* s)
+{
+    std::vector<std::string> items;
+    std::stringstream in(s);
+    std::string item;
+    while (std::getline(in, item, ','))
+        if (!item.empty()) items.push_back(item);
+    return items;
+}
+
+bool parseSizes(const char* s, std::vector<GridSize>& out)
+{
+    out.clear();
+    for (const std::string& item : splitList(s))
+    {
+        const std::size_t x = item.find('x');
+        GridSize size;
+        size.rows = std::atoi(item.c_str());
+        size.cols = x == std::string::npos ? size.rows : std::atoi(item.c_str() + x + 1);
+        if (size.rows < maze::Grid::cMinDim || size.cols < maze::Grid::cMinDim || size.rows > maze::Grid::cMaxDim ||
+            size.cols > maze::Grid::cMaxDim)
+            return false;
+        out.push_back(size);
+    }
+    return !out.empty();
+}
+
+bool parseDensities(const char* s, std::vector<float>& out)
+{
+    out.clear();
+    for (const std::string& item : splitList(s))
+    {
+        const float d = float(std::atof(item.c_str()));
+        if (d < 0 || d > 1) return false;
+        out.push_back(d);
+    }
+    return !out.empty();
+}
+
+bool parseAlgorithms(const char* s, std::vector<AlgorithmEntry>& out)
+{
+    out.clear();
+    for (const std::string& item : splitList(s))
+    {
+        bool known = false;
+        for (const AlgorithmEntry& e : cAlgorithms)
+        {
+            if (item == "all" || item == e.name)
+            {
+                out.push_back(e);
+                known = true;
+            }
+        }
+        if (!known) return false;
+    }
+    return !out.empty();
+}
+
+bool parseArgs(int argc, const char* argv[], BenchOptions& o)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* a = argv[i];
+        auto next = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : nullptr; };
+        const char* v = nullptr;
+        if (std::strcmp(a, "--sizes") == 0 && (v = next())) { if (!parseSizes(v, o.sizes)) return false; }
+        else if (std::strcmp(a, "--densities") == 0 && (v = next())) { if (!parseDensities(v, o.densities)) return false; }
+        else if (std::strcmp(a, "--alg") == 0 && (v = next())) { if (!parseAlgorithms(v, o.algorithms)) return false; }
+        else if (std::strcmp(a, "--seed") == 0 && (v = next())) o.seed = unsigned(std::strtoul(v, nullptr, 10));
+        else if (std::strcmp(a, "--repeat") == 0 && (v = next())) o.repeat = std::max(1, std::atoi(v));
+        else if (std::strcmp(a, "--csv") == 0 && (v = next())) o.csvPath = v;
+        else if (std::strcmp(a, "--compare") == 0 && (v = next())) o.comparePath = v;
+        else if (std::strcmp(a, "--tolerance") == 0 && (v = next())) o.tolerance = std::max(0.0, std::atof(v));
+        else if (std::strcmp(a, "--floor") == 0 && (v = next())) o.floorNS = std::max(0.0, std::atof(v)) * 1e3;
+        else return false;
+    }
+    return true;
+}
+
+// Takes reps samples of op, which returns the work it did; setup runs
+// untimed before every call
+template <class Setup, class Op>
+Result measure(const char* bench, const maze::Grid& grid, float density, int reps, Setup&& setup, Op&& op)
+{
+    std::vector<double> ns(static_cast<std::size_t>(reps));
+    Result r;
+    for (double& t : ns)
+    {
+        double total = 0;
+        int runs = 0;
+        do
+        {
+            setup();
+            auto t0 = std::chrono::steady_clock::now();
+            r.items = op();
+            auto t1 = std::chrono::steady_clock::now();
+            total += std::chrono::duration<double, std::nano>(t1 - t0).count();
+            runs++;
+        } while (total < cMinSampleNS);
+        t = total / runs;
+    }
+    std::sort(ns.begin(), ns.end());
+    r.bench = bench;
+    r.rows = grid.rows();
+    r.cols = grid.cols();
+    r.density = density;
+    r.reps = reps;
+    r.medianNS = ns[ns.size() / 2];
+    r.minNS = ns.front();
+    return r;
+}
+
+std::string formatTime(double ns)
+{
+    char buf[32];
+    if (ns >= 1e6) std::snprintf(buf, sizeof(buf), "%.3f ms", ns / 1e6);
+    else if (ns >= 1e3) std::snprintf(buf, sizeof(buf), "%.3f us", ns / 1e3);
+    else std::snprintf(buf, sizeof(buf), "%.2f ns", ns);
+    return buf;
+}
+
+// Identifies a measurement across runs
+std::string keyOf(const Result& r)
+{
+    char buf[96];
+    std::snprintf(buf, sizeof(buf), "%s,%d,%d,%.2f", r.bench.c_str(), r.rows, r.cols, r.density);
+    return buf;
+}
+
+void printResult(const Result& r)
+{
+    std::printf("%-16s %5dx%-5d d=%.2f  median %12s  min %12s  items %llu\n", r.bench.c_str(), r.rows, r.cols, r.density,
+                formatTime(r.medianNS).c_str(), formatTime(r.minNS).c_str(), r.items);
+    std::fflush(stdout);
+}
+
+bool writeCsv(const std::string& path, const std::vector<Result>& results)
+{
+    std::ofstream out(path);
+    out << "bench,rows,cols,density,reps,median_ns,min_ns,items\n";
+    char buf[96];
+    for (const Result& r : results)
+    {
+        std::snprintf(buf, sizeof(buf), ",%d,%.1f,%.1f,%llu\n", r.reps, r.medianNS, r.minNS, r.items);
+        out << keyOf(r) << buf;
+    }
+    return bool(out);
+}
+
+bool readCsv(const std::string& path, std::map<std::string, Result>& results)
+{
+    std::ifstream in(path);
+    std::string line;
+    if (!in || !std::getline(in, line))
+        return false;
+    while (std::getline(in, line))
+    {
+        std::stringstream fields(line);
+        Result r;
+        std::string density, reps, median, min, items;
+        if (!std::getline(fields, r.bench, ',')) continue;
+        fields >> r.rows;
+        fields.ignore(1);
+        fields >> r.cols;
+        fields.ignore(1);
+        if (!std::getline(fields, density, ',') || !std::getline(fields, reps, ',') || !std::getline(fields, median, ',') ||
+            !std::getline(fields, min, ',') || !std::getline(fields, items))
+            return false;
+        r.density = float(std::atof(density.c_str()));
+        r.reps = std::atoi(reps.c_str());
+        r.medianNS = std::atof(median.c_str());
+        r.minNS = std::atof(min.c_str());
+        r.items = std::strtoull(items.c_str(), nullptr, 10);
+        results[keyOf(r)] = r;
+    }
+    return true;
+}
+
+// Returns the number of regressions: benches slower by more than tolerance
+// percent and, per run, by more than floorNS
+int compare(const std::vector<Result>& results, const std::map<std::string, Result>& baseline, double tolerance, double floorNS)
+{
+    std::printf("\nfastest runs compared with the baseline (tolerance %.0f%%, floor %s):\n", tolerance, formatTime(floorNS).c_str());
+    int regressions = 0;
+    for (const Result& r : results)
+    {
+        auto it = baseline.find(keyOf(r));
+        if (it == baseline.end())
+        {
+            std::printf("%-16s %5dx%-5d d=%.2f  %12s  new\n", r.bench.c_str(), r.rows, r.cols, r.density, formatTime(r.minNS).c_str());
+            continue;
+        }
+        // the fastest runs, which vary much less between runs than the medians
+        const Result& b = it->second;
+        const double change = b.minNS > 0 ? 100.0 * (r.minNS / b.minNS - 1.0) : 0.0;
+        const double diffNS = (r.minNS - b.minNS) * r.calls;
+        const bool slower = change > tolerance && diffNS > floorNS;
+        const bool faster = change < -tolerance && -diffNS > floorNS;
+        const char* verdict = slower ? "REGRESSION" : faster ? "faster" : "ok";
+        if (slower) regressions++;
+        // different work means the search itself changed, not only its speed
+        std::printf("%-16s %5dx%-5d d=%.2f  %12s -> %12s  %+7.1f%%  %s%s\n", r.bench.c_str(), r.rows, r.cols, r.density,
+                    formatTime(b.minNS).c_str(), formatTime(r.minNS).c_str(), change, verdict,
+                    b.items != r.items ? " (work changed)" : "");
+    }
+    std::printf("%d regression%s\n", regressions, regressions == 1 ? "" : "s");
+    return regressions;
+}
+
+// All measurements on one grid size and density
+void benchGrid(const BenchOptions& o, GridSize size, float density, std::vector<Result>& results)
+{
+    auto add = [&](const Result& r)
+    {
+        printResult(r);
+        results.push_back(r);
+    };
+    auto none = [] {};
+
+    maze::Grid grid(size.rows, size.cols);
+    maze::GenOptions gen;
+    gen.density = density;
+    add(measure("generate", grid, density, o.repeat, none, [&] { maze::generate(grid, gen, o.seed); return grid.size(); }));
+
+    // headless searches, as the CLI and the batch solver run them
+    maze::SearchEngine search(grid);
+    for (const AlgorithmEntry& e : o.algorithms)
+    {
+        search.options().algorithm = e.alg;
+        if (e.alg == maze::Algorithm::HPAStar)
+            search.prepareHierarchy();
+        const std::string name = std::string("search.") + e.name;
+        // D* Lite would otherwise repair its previous result for free
+        add(measure(name.c_str(), grid, density, o.repeat, [&] { search.dropIncremental(); },
+                    [&] { search.run(); return search.expansions(); }));
+    }
+
+    // the engine as the GUI drives it: change log on, mirror and raster fed from it
+    maze::SearchEngine view(grid);
+    view.trackChanges(true);
+    view.options().algorithm = maze::Algorithm::BFS;
+    maze::StateMirror mirror;
+    mirror.resize(grid.size());
+    maze::CellRaster raster;
+    const double cell = std::min(cViewWidth / grid.cols(), cViewHeight / grid.rows());
+    int lod = 1;
+    while (lod * cell < 1)
+        lod *= 2;
+    raster.setWindow(0, 0, grid.rows() - 1, grid.cols() - 1, lod);
+    auto resetView = [&]
+    {
+        view.clear();
+        view.clearChanges();
+        mirror.clear();
+        raster.render(grid, mirror);
+    };
+    // the finished search's changes into the mirror, queuing their texels
+    auto syncMirror = [&]
+    {
+        const std::size_t changes = view.changeCount();
+        view.forEachChange([&](std::size_t i)
+        {
+            mirror.set(i, view.state(i), view.isBackward(i));
+            const maze::Cell c = grid.cellAt(i);
+            raster.updateCell(c.r, c.c);
+        });
+        view.clearChanges();
+        return changes;
+    };
+
+    view.run();
+    // read through a volatile pointer, so the calls are not folded into one
+    const maze::SearchEngine* volatile counted = &view;
+    Result count = measure("visitedCount", grid, density, o.repeat, none, [&]
+    {
+        unsigned long long sum = 0;
+        for (int k = 0; k < cCountCalls; k++)
+            sum += counted->visitedCount();
+        return sum / cCountCalls;
+    });
+    count.medianNS /= cCountCalls;
+    count.minNS /= cCountCalls;
+    count.calls = cCountCalls;
+    add(count);
+
+    // the frame after a finished search: its changes into the mirror, then the changed texels
+    add(measure("draw.changes", grid, density, o.repeat, [&] { resetView(); view.run(); }, [&]
+    {
+        const std::size_t changes = syncMirror();
+        raster.flush(grid, mirror);
+        return changes;
+    }));
+    // a whole frame (after zoom, pan or recoloring) of the mirror left by the last run
+    add(measure("draw.full", grid, density, o.repeat, none, [&] { raster.render(grid, mirror); return raster.texelCount(); }));
+    // the engine and mirror side of MazeModel::clearSearchVisualization()
+    add(measure("clear", grid, density, o.repeat, [&] { resetView(); view.run(); syncMirror(); }, [&]
+    {
+        const std::size_t visited = view.visitedCount();
+        view.clear();
+        mirror.clear();
+        return visited;
+    }));
+}
+
+} // namespace
+
+int main(int argc, const char* argv[])
+{
+    BenchOptions o;
+    if (!parseArgs(argc, argv, o))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::map<std::string, Result> baseline;
+    if (!o.comparePath.empty() && !readCsv(o.comparePath, baseline))
+    {
+        std::fprintf(stderr, "cannot read baseline '%s'\n", o.comparePath.c_str());
+        return 2;
+    }
+
+    std::printf("bench: seed=%u repeat=%d\n", o.seed, o.repeat);
+    std::vector<Result> results;
+    for (const GridSize& size : o.sizes)
+        for (float density : o.densities)
+            benchGrid(o, size, density, results);
+
+    if (!o.csvPath.empty() && !writeCsv(o.csvPath, results))
+    {
+        std::fprintf(stderr, "cannot write '%s'\n", o.csvPath.c_str());
+        return 2;
+    }
+    if (!o.comparePath.empty())
+        return compare(results, baseline, o.tolerance, o.floorNS) > 0 ? 1 : 0;
+    return 0;
+}
@@ -0,0 +1,780 @@
+// Headless batch solver: generates or loads a maze and runs the search engine
+// to completion without any canvas, timer or per-step redraw.
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../core/Grid.h"
+#include "../core/Generator.h"
+#include "../core/SearchEngine.h"
+#include "../core/MazeText.h"
+#include "../core/MazeFile.h"
+#include "../core/MovingAI.h"
+#include "../core/BatchSolver.h"
+#include "../core/Connectivity.h"
+#include "../core/PathCache.h"
+
+namespace
+{
+
+struct CliOptions
+{
+    int rows = 25;
+    int cols = 25;
+    unsigned seed = 0;
+    maze::GenOptions gen;
+    std::vector<maze::Algorithm> algorithms{maze::Algorithm::AStar};
+    std::vector<maze::OpenListKind> openLists{maze::OpenListKind::BinaryHeap};
+    std::vector<maze::HeuristicKind> heuristics{maze::HeuristicKind::Auto};
+    bool diagonal = false;
+    maze::CornerRule corners = maze::CornerRule::Cut;
+    bool jumpTable = false;
+    int clusterSize = maze::PathHierarchy::cDefaultClusterSize;
+    int landmarks = maze::LandmarkTable::cDefaultCount;
+    int repeat = 1;
+    int queries = 0;        // > 0: batch mode with random start/goal pairs
+    unsigned threads = 0;   // batch workers, 0 = all hardware threads
+    int goals = 0;          // > 0: batch goals drawn from this many cells
+    int cache = 0;          // > 0: path cache entries
+    bool print = false;
+    bool trace = false;     // record the runs and report the trace size
+    int replan = 0;         // D* Lite: edits to replan after
+    bool connectivity = false;  // reject unreachable queries with a component index
+    std::string loadPath;
+    std::string savePath;
+    std::string scenPath;   // MovingAI scenario to run
+    bool perQuery = false;  // scenario: print every query
+};
+
+void usage(const char* exe)
+{
+    std::fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --rows N, --cols N     grid size for a generated maze (default 25x25, max 16384)\n"
+        "  --density D            wall probability 0..1 (default 0.28)\n"
+        "  --seed S               generator seed (default random)\n"
+        "  --no-guarantee         do not carve the guaranteed corridor\n"
+        "  --load FILE            load a text maze ('#' wall, '.' free, 'S', 'G'), a\n"
+        "                         binary one (mapped, not read) or a MovingAI .map\n"
+        "  --save FILE            save the maze as text, or binary if FILE ends in .mzb\n"
+        "                         (with the components and landmark tables, if any)\n"
+        "  --alg NAME             bfs | dijkstra | astar | jps | bibfs | biastar | dstar | hpa |\n"
+        "                         all (default astar)\n"
+        "  --jump-table           JPS+: precompute jump distances for jps\n"
+        "  --cluster K            hpa: cluster size in cells (default 16)\n"
+        "  --open NAME            heap2 | heap4 | pairing | bucket | all (default heap2)\n"
+        "  --diagonal             allow diagonal moves (cost 1.4)\n"
+        "  --corners NAME         diagonal moves past walls: cut | nosqueeze | nocut\n"
+        "                         (default cut)\n"
+        "  --heuristic NAME       astar, jps, biastar: auto | manhattan | octile |\n"
+        "                         chebyshev | euclidean | alt | all (default auto:\n"
+        "                         manhattan, or octile with --diagonal)\n"
+        "  --landmarks K          alt: number of landmarks (default 8)\n"
+        "  --repeat K             run each search K times and report the average\n"
+        "  --queries N            batch mode: solve N random start/goal pairs\n"
+        "  --threads T            batch worker threads (default: all cores)\n"
+        "  --goals G              batch mode: draw the goals from G random cells\n"
+        "  --cache N              keep up to N solved paths in an LRU cache and reuse\n"
+        "                         least-cost trees of often-asked goals\n"
+        "  --trace                record every run and report the trace size\n"
+        "  --connectivity         label connected components first; queries between\n"
+        "                         different components fail without a search\n"
+        "  --scen FILE            run the queries of a MovingAI .scen file on its map (or\n"
+        "                         the --load one); with --diagonal --corners nocut the\n"
+        "                         costs are checked against the file's optimal ones\n"
+        "  --per-query            scen: print every query\n"
+        "  --replan N             dstar: block and reopen N random path cells, replanning\n"
+        "                         after each edit, and compare with A* from scratch\n"
+        "  --print                print the maze with the found path\n", exe);
+}
+
+bool parseAlgorithm(const char* s, std::vector<maze::Algorithm>& out)
+{
+    out.clear();
+    if (std::strcmp(s, "bfs") == 0) out.push_back(maze::Algorithm::BFS);
+    else if (std::strcmp(s, "dijkstra") == 0) out.push_back(maze::Algorithm::Dijkstra);
+    else if (std::strcmp(s, "astar") == 0) out.push_back(maze::Algorithm::AStar);
+    else if (std::strcmp(s, "jps") == 0) out.push_back(maze::Algorithm::JPS);
+    else if (std::strcmp(s, "bibfs") == 0) out.push_back(maze::Algorithm::BidirectionalBFS);
+    else if (std::strcmp(s, "biastar") == 0) out.push_back(maze::Algorithm::BidirectionalAStar);
+    else if (std::strcmp(s, "dstar") == 0) out.push_back(maze::Algorithm::DStarLite);
+    else if (std::strcmp(s, "hpa") == 0) out.push_back(maze::Algorithm::HPAStar);
+    else if (std::strcmp(s, "all") == 0)
+        out = {maze::Algorithm::BFS, maze::Algorithm::Dijkstra, maze::Algorithm::AStar, maze::Algorithm::JPS,
+               maze::Algorithm::BidirectionalBFS, maze::Algorithm::BidirectionalAStar, maze::Algorithm::DStarLite,
+               maze::Algorithm::HPAStar};
+    return !out.empty();
+}
+
+bool parseOpenList(const char* s, std::vector<maze::OpenListKind>& out)
+{
+    const maze::OpenListKind all[] = {maze::OpenListKind::BinaryHeap, maze::OpenListKind::QuaternaryHeap,
+                                      maze::OpenListKind::PairingHeap, maze::OpenListKind::BucketQueue};
+    out.clear();
+    for (auto k : all)
+        if (std::strcmp(s, "all") == 0 || std::strcmp(s, maze::openListName(k)) == 0)
+            out.push_back(k);
+    return !out.empty();
+}
+
+bool parseHeuristic(const char* s, std::vector<maze::HeuristicKind>& out)
+{
+    const maze::HeuristicKind all[] = {maze::HeuristicKind::Manhattan, maze::HeuristicKind::Octile,
+                                       maze::HeuristicKind::Chebyshev, maze::HeuristicKind::Euclidean,
+                                       maze::HeuristicKind::Landmarks};
+    out.clear();
+    if (std::strcmp(s, "auto") == 0)
+        out.push_back(maze::HeuristicKind::Auto);
+    for (auto h : all)
+        if (std::strcmp(s, "all") == 0 || std::strcmp(s, maze::heuristicName(h)) == 0)
+            out.push_back(h);
+    return !out.empty();
+}
+
+bool parseCorners(const char* s, maze::CornerRule& out)
+{
+    for (auto r : {maze::CornerRule::Cut, maze::CornerRule::NoSqueeze, maze::CornerRule::NoCut})
+    {
+        if (std::strcmp(s, maze::cornerRuleName(r)) == 0)
+        {
+            out = r;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseArgs(int argc, const char* argv[], CliOptions& o)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* a = argv[i];
+        auto next = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : nullptr; };
+        const char* v = nullptr;
+
+        if (std::strcmp(a, "--rows") == 0 && (v = next())) o.rows = std::atoi(v);
+        else if (std::strcmp(a, "--cols") == 0 && (v = next())) o.cols = std::atoi(v);
+        else if (std::strcmp(a, "--density") == 0 && (v = next())) o.gen.density = float(std::atof(v));
+        else if (std::strcmp(a, "--seed") == 0 && (v = next())) o.seed = unsigned(std::strtoul(v, nullptr, 10));
+        else if (std::strcmp(a, "--no-guarantee") == 0) o.gen.guaranteePath = false;
+        else if (std::strcmp(a, "--load") == 0 && (v = next())) o.loadPath = v;
+        else if (std::strcmp(a, "--save") == 0 && (v = next())) o.savePath = v;
+        else if (std::strcmp(a, "--alg") == 0 && (v = next())) { if (!parseAlgorithm(v, o.algorithms)) return false; }
+        else if (std::strcmp(a, "--open") == 0 && (v = next())) { if (!parseOpenList(v, o.openLists)) return false; }
+        else if (std::strcmp(a, "--diagonal") == 0) o.diagonal = true;
+        else if (std::strcmp(a, "--corners") == 0 && (v = next())) { if (!parseCorners(v, o.corners)) return false; }
+        else if (std::strcmp(a, "--heuristic") == 0 && (v = next())) { if (!parseHeuristic(v, o.heuristics)) return false; }
+        else if (std::strcmp(a, "--jump-table") == 0) o.jumpTable = true;
+        else if (std::strcmp(a, "--cluster") == 0 && (v = next())) o.clusterSize = std::atoi(v);
+        else if (std::strcmp(a, "--landmarks") == 0 && (v = next())) o.landmarks = std::atoi(v);
+        else if (std::strcmp(a, "--repeat") == 0 && (v = next())) o.repeat = std::max(1, std::atoi(v));
+        else if (std::strcmp(a, "--queries") == 0 && (v = next())) o.queries = std::max(0, std::atoi(v));
+        else if (std::strcmp(a, "--threads") == 0 && (v = next())) o.threads = unsigned(std::max(0, std::atoi(v)));
+        else if (std::strcmp(a, "--goals") == 0 && (v = next())) o.goals = std::max(0, std::atoi(v));
+        else if (std::strcmp(a, "--cache") == 0 && (v = next())) o.cache = std::max(0, std::atoi(v));
+        else if (std::strcmp(a, "--print") == 0) o.print = true;
+        else if (std::strcmp(a, "--trace") == 0) o.trace = true;
+        else if (std::strcmp(a, "--connectivity") == 0) o.connectivity = true;
+        else if (std::strcmp(a, "--scen") == 0 && (v = next())) o.scenPath = v;
+        else if (std::strcmp(a, "--per-query") == 0) o.perQuery = true;
+        else if (std::strcmp(a, "--replan") == 0 && (v = next())) o.replan = std::max(0, std::atoi(v));
+        else return false;
+    }
+    return o.rows > 0 && o.cols > 0 && o.rows <= maze::Grid::cMaxDim && o.cols <= maze::Grid::cMaxDim;
+}
+
+// Binary maze files are told apart by their extension when saving
+bool saveBinary(const std::string& path)
+{
+    const std::string ext = ".mzb";
+    return path.size() > ext.size() && path.compare(path.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+void printSolved(const maze::Grid& grid, const maze::SearchEngine& search)
+{
+    std::string line;
+    for (int r = 0; r < grid.rows(); r++)
+    {
+        line.assign(grid.cols(), '.');
+        for (int c = 0; c < grid.cols(); c++)
+        {
+            if (grid.isWall(r,c)) line[c] = '#';
+            else if (search.state(grid.index(r,c)) == maze::CellState::Path) line[c] = '*';
+        }
+        if (grid.start().r == r) line[grid.start().c] = 'S';
+        if (grid.goal().r == r) line[grid.goal().c] = 'G';
+        std::cout << line << '\n';
+    }
+}
+
+// Random pairs of free cells; deterministic for a given seed. goals > 0
+// draws every goal from that many random cells.
+std::vector<maze::Query> randomQueries(const maze::Grid& grid, int count, unsigned seed, int goals)
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> rowDist(0, grid.rows() - 1), colDist(0, grid.cols() - 1);
+    auto freeCell = [&]() -> maze::Cell
+    {
+        for (int tries = 0; tries < 1000; tries++)
+        {
+            maze::Cell c{rowDist(rng), colDist(rng)};
+            if (!grid.isWall(c)) return c;
+        }
+        return grid.start();
+    };
+
+    std::vector<maze::Query> queries(static_cast<std::size_t>(count));
+    if (goals > 0)
+    {
+        std::vector<maze::Cell> pool(static_cast<std::size_t>(goals));
+        for (auto& g : pool)
+            g = freeCell();
+        std::uniform_int_distribution<std::size_t> pick(0, pool.size() - 1);
+        for (auto& q : queries)
+            q = {freeCell(), pool[pick(rng)]};
+        return queries;
+    }
+    for (auto& q : queries)
+        q = {freeCell(), freeCell()};
+    return queries;
+}
+
+// Hit rates of the cache; laterMS < 0 if there was only one round
+void printCache(const maze::PathCache& cache, double firstMS, double laterMS, std::size_t queries)
+{
+    const maze::PathCache::Stats st = cache.stats();
+    std::printf("          cache: %llu hits, %llu tree hits, %llu misses (%.1f%% hit rate), %zu entries, %zu trees (%llu built), %.1f MB\n",
+                (unsigned long long)st.hits, (unsigned long long)st.treeHits, (unsigned long long)st.misses, 100.0 * st.hitRate(),
+                cache.size(), cache.treeCount(), (unsigned long long)st.treesBuilt, cache.bytes() / 1048576.0);
+    if (laterMS >= 0 && queries > 0)
+        std::printf("          cache: first round %.3f ms, later rounds %.3f ms (%.2f us/query)\n", firstMS, laterMS,
+                    1000.0 * laterMS / double(queries));
+}
+
+int runBatch(const maze::Grid& grid, const CliOptions& o, unsigned seed, const maze::ConnectivityIndex* components,
+             const std::shared_ptr<maze::LandmarkTable>& landmarks)
+{
+    const std::vector<maze::Query> queries = randomQueries(grid, o.queries, seed, o.goals);
+    maze::PathCache cache(std::size_t(o.cache));
+    maze::BatchSolver batch(o.threads);
+    if (o.cache > 0)
+        batch.setCache(&cache);
+    batch.setKeepPaths(false);
+    batch.setConnectivity(components);
+    batch.options().diagonal = o.diagonal;
+    batch.options().corners = o.corners;
+    batch.options().jumpTable = o.jumpTable;
+    batch.options().clusterSize = o.clusterSize;
+    batch.options().landmarks = o.landmarks;
+    if (landmarks)
+        batch.useLandmarks(landmarks);
+    std::printf("batch: %d queries on %u threads\n", o.queries, batch.threadCount());
+
+    int rc = 0;
+    bool landmarksBuilt = landmarks != nullptr;
+    std::vector<maze::QueryResult> results;
+    for (auto alg : o.algorithms)
+    {
+        batch.options().algorithm = alg;
+        const bool fifo = (alg == maze::Algorithm::BFS || alg == maze::Algorithm::BidirectionalBFS);
+        const bool dstar = (alg == maze::Algorithm::DStarLite);
+        const bool hpa = (alg == maze::Algorithm::HPAStar);
+        std::size_t nOpen = (fifo || dstar || hpa) ? 1 : o.openLists.size();
+        if (hpa && !queries.empty())
+        {
+            // one untimed query builds the shared abstract graph
+            auto t0 = std::chrono::steady_clock::now();
+            batch.solve(grid, {queries.front()}, results);
+            auto t1 = std::chrono::steady_clock::now();
+            std::printf("hierarchy: warm-up query (builds it) %.3f ms\n", std::chrono::duration<double, std::milli>(t1 - t0).count());
+        }
+        std::size_t nHeur = maze::usesHeuristic(alg) ? o.heuristics.size() : 1;
+        for (std::size_t k = 0; k < nOpen * nHeur; k++)
+        {
+            batch.options().openList = o.openLists[k / nHeur];
+            batch.options().heuristic = o.heuristics[k % nHeur];
+            if (batch.options().heuristic == maze::HeuristicKind::Landmarks && maze::usesHeuristic(alg) && !landmarksBuilt &&
+                !queries.empty())
+            {
+                // one untimed query builds the shared landmark tables
+                auto t0 = std::chrono::steady_clock::now();
+                batch.solve(grid, {queries.front()}, results);
+                auto t1 = std::chrono::steady_clock::now();
+                std::printf("landmarks: warm-up query (builds them) %.3f ms\n", std::chrono::duration<double, std::milli>(t1 - t0).count());
+                landmarksBuilt = true;
+            }
+
+            // every configuration starts cold, or it would answer from the previous one's trees
+            cache.clear();
+            cache.resetStats();
+            double totalMS = 0, firstMS = 0;
+            for (int rep = 0; rep < o.repeat; rep++)
+            {
+                auto t0 = std::chrono::steady_clock::now();
+                batch.solve(grid, queries, results);
+                auto t1 = std::chrono::steady_clock::now();
+                totalMS += std::chrono::duration<double, std::milli>(t1 - t0).count();
+                if (rep == 0) firstMS = totalMS;
+            }
+            const double ms = totalMS / o.repeat;
+
+            std::size_t solved = 0;
+            long long costSum = 0;
+            for (const auto& r : results)
+                if (r.solved) { solved++; costSum += r.cost; }
+
+            std::printf("%-9s %-8s %-9s solved=%zu/%zu avgCost=%.2f time=%.3f ms throughput=%.0f queries/s\n",
+                        (alg == maze::Algorithm::JPS && o.jumpTable) ? "JPS+" : maze::algorithmName(alg),
+                        fifo ? "fifo" : dstar ? "indexed" : hpa ? "abstract" : maze::openListName(o.openLists[k / nHeur]),
+                        maze::usesHeuristic(alg) ? maze::heuristicName(o.heuristics[k % nHeur]) : "-",
+                        solved, results.size(), solved ? double(costSum) / double(solved) / maze::cCostScale : 0.0, ms,
+                        ms > 0 ? 1000.0 * double(results.size()) / ms : 0.0);
+            if (o.cache > 0)
+                printCache(cache, firstMS, o.repeat > 1 ? (totalMS - firstMS) / (o.repeat - 1) : -1.0, results.size());
+            if (solved != results.size()) rc = 3;
+        }
+    }
+    return rc;
+}
+
+// D* Lite: blocks random cells of the current path and opens them again,
+// replanning after every edit, and compares each result with A* from scratch
+int runReplan(maze::Grid& grid, maze::SearchEngine& search, const CliOptions& o, unsigned seed,
+              maze::ConnectivityIndex& components)
+{
+    maze::SearchEngine full(grid);
+    full.options().algorithm = maze::Algorithm::AStar;
+    full.options().diagonal = o.diagonal;
+    full.options().corners = o.corners;
+
+    std::mt19937 rng(seed);
+    double replanMS = 0, fullMS = 0;
+    unsigned long long replanExp = 0, fullExp = 0;
+    int edits = 0, rc = 0;
+    for (int k = 0; k < o.replan && search.pathLength() > 2; k++)
+    {
+        const std::vector<maze::Cell>& path = search.path();
+        const maze::Cell cell = path[1 + rng() % (path.size() - 2)];
+        for (int rep = 0; rep < 2; rep++)
+        {
+            grid.toggleWall(cell.r, cell.c);
+            search.wallChanged(cell);
+            components.wallChanged(cell);
+
+            auto t0 = std::chrono::steady_clock::now();
+            search.run();
+            auto t1 = std::chrono::steady_clock::now();
+            full.run();
+            auto t2 = std::chrono::steady_clock::now();
+            replanMS += std::chrono::duration<double, std::milli>(t1 - t0).count();
+            fullMS += std::chrono::duration<double, std::milli>(t2 - t1).count();
+            replanExp += search.expansions();
+            fullExp += full.expansions();
+            edits++;
+            if (search.pathCost() != full.pathCost()) rc = 3;
+        }
+    }
+    if (edits > 0)
+        std::printf("          replan: %d edits, avg %.3f ms %.0f expansions (A* from scratch: %.3f ms %.0f expansions)%s\n",
+                    edits, replanMS / edits, double(replanExp) / edits, fullMS / edits, double(fullExp) / edits,
+                    rc ? " COST MISMATCH" : "");
+    return rc;
+}
+
+// Nearest-rank percentile of sorted values
+double percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty()) return 0.0;
+    const std::size_t rank = std::size_t(std::ceil(p * double(sorted.size())));
+    return sorted[std::min(std::max<std::size_t>(rank, 1), sorted.size()) - 1];
+}
+
+// A scenario names its map as it lies in the benchmark tree (maps/dao/x.map):
+// tries that name, then next to the scenario, with and without the directories
+std::string scenarioMapPath(const std::string& scenPath, const std::string& map)
+{
+    const std::size_t slash = scenPath.find_last_of("/\\");
+    const std::string dir = slash == std::string::npos ? std::string() : scenPath.substr(0, slash + 1);
+    const std::size_t base = map.find_last_of("/\\");
+    const std::string candidates[] = {map, dir + map, dir + (base == std::string::npos ? map : map.substr(base + 1))};
+    for (const std::string& path : candidates)
+        if (std::ifstream(path)) return path;
+    return map;
+}
+
+// Runs the queries of a MovingAI scenario one after another on one engine
+// and reports expansions, costs against the file's optimal ones and the
+// latency percentiles per configuration
+int runScenario(const maze::Grid& grid, const CliOptions& o, const std::vector<maze::ScenarioQuery>& scenario,
+                const maze::ConnectivityIndex* components, const std::shared_ptr<maze::LandmarkTable>& landmarks)
+{
+    // the reference costs hold for octile moves without corner cutting only
+    const bool compare = o.diagonal && o.corners == maze::CornerRule::NoCut;
+    std::vector<maze::ScenarioQuery> queries;
+    std::size_t otherSize = 0;
+    for (const auto& q : scenario)
+    {
+        if (q.mapWidth != grid.cols() || q.mapHeight != grid.rows()) otherSize++;
+        if (grid.inside(q.start) && grid.inside(q.goal) && !grid.isWall(q.start) && !grid.isWall(q.goal))
+            queries.push_back(q);
+    }
+    std::printf("scenario: %s, %zu queries", o.scenPath.c_str(), queries.size());
+    if (queries.size() != scenario.size())
+        std::printf(" (%zu skipped: endpoint outside the map or on a wall)", scenario.size() - queries.size());
+    std::printf("\n");
+    if (otherSize > 0)
+        std::printf("scenario: %zu queries were made for a map of another size\n", otherSize);
+    if (!compare)
+        std::printf("scenario: the optimal costs are octile without corner cutting; use --diagonal --corners nocut to check them\n");
+
+    maze::SearchEngine search(grid);
+    if (components)
+        search.useConnectivity(components);
+    if (landmarks)
+        search.useLandmarks(landmarks);
+    search.options().diagonal = o.diagonal;
+    search.options().corners = o.corners;
+    search.options().jumpTable = o.jumpTable;
+    search.options().clusterSize = o.clusterSize;
+    search.options().landmarks = o.landmarks;
+    maze::PathCache cache(std::size_t(o.cache));
+    if (o.cache > 0)
+        search.useCache(&cache);
+
+    int rc = 0;
+    std::vector<double> latency(queries.size());
+    for (auto alg : o.algorithms)
+    {
+        search.options().algorithm = alg;
+        const bool fifo = (alg == maze::Algorithm::BFS || alg == maze::Algorithm::BidirectionalBFS);
+        const bool dstar = (alg == maze::Algorithm::DStarLite);
+        const bool hpa = (alg == maze::Algorithm::HPAStar);
+        std::size_t nOpen = (fifo || dstar || hpa) ? 1 : o.openLists.size();
+        std::size_t nHeur = maze::usesHeuristic(alg) ? o.heuristics.size() : 1;
+        for (std::size_t k = 0; k < nOpen * nHeur; k++)
+        {
+            search.options().openList = o.openLists[k / nHeur];
+            search.options().heuristic = o.heuristics[k % nHeur];
+            const char* algName = (alg == maze::Algorithm::JPS && o.jumpTable) ? "JPS+" : maze::algorithmName(alg);
+            const char* openName = fifo ? "fifo" : dstar ? "indexed" : hpa ? "abstract" : maze::openListName(o.openLists[k / nHeur]);
+            const char* heurName = maze::usesHeuristic(alg) ? maze::heuristicName(o.heuristics[k % nHeur]) : "-";
+
+            // tables and graphs shared by all queries are built before the clock runs
+            if (search.options().heuristic == maze::HeuristicKind::Landmarks && maze::usesHeuristic(alg) && !search.landmarks())
+                search.prepareLandmarks();
+            if (hpa)
+                search.prepareHierarchy();
+            if (alg == maze::Algorithm::JPS && o.jumpTable && !queries.empty())
+                search.run(queries.front().start, queries.front().goal);
+
+            cache.clear();
+            cache.resetStats();
+            std::size_t solved = 0, optimal = 0, longer = 0, shorter = 0;
+            unsigned long long expansions = 0;
+            double costSum = 0, worst = 0, worstRel = 0;
+            for (std::size_t i = 0; i < queries.size(); i++)
+            {
+                const maze::ScenarioQuery& q = queries[i];
+                double us = 0;
+                bool ok = false;
+                for (int rep = 0; rep < o.repeat; rep++)
+                {
+                    search.dropIncremental();
+                    auto t0 = std::chrono::steady_clock::now();
+                    ok = search.run(q.start, q.goal);
+                    auto t1 = std::chrono::steady_clock::now();
+                    us += std::chrono::duration<double, std::micro>(t1 - t0).count();
+                }
+                latency[i] = us / o.repeat;
+                expansions += search.expansions();
+
+                const double length = ok ? maze::octileLength(search.path()) : -1.0;
+                const double diff = length - q.optimal;
+                if (ok)
+                {
+                    solved++;
+                    costSum += length;
+                    // the engine weighs diagonals 1.4, so the file's 8 decimals are compared loosely
+                    const double tol = 1e-4 * std::max(1.0, q.optimal);
+                    if (diff > tol) { longer++; worst = std::max(worst, diff); worstRel = std::max(worstRel, diff / std::max(1.0, q.optimal)); }
+                    else if (diff < -tol) shorter++;
+                    else optimal++;
+                }
+                if (o.perQuery)
+                {
+                    std::printf("          #%zu bucket=%d (%d,%d)->(%d,%d) solved=%d expansions=%llu cost=%.4f optimal=%.4f",
+                                i, q.bucket, q.start.r, q.start.c, q.goal.r, q.goal.c, ok ? 1 : 0,
+                                (unsigned long long)search.expansions(), length, q.optimal);
+                    if (compare && ok) std::printf(" diff=%+.4f", diff);
+                    std::printf(" time=%.1f us\n", latency[i]);
+                }
+            }
+
+            const double totalMS = std::accumulate(latency.begin(), latency.end(), 0.0) / 1000.0;
+            std::sort(latency.begin(), latency.end());
+            const double n = queries.empty() ? 1.0 : double(queries.size());
+            std::printf("%-9s %-8s %-9s solved=%zu/%zu avgExpansions=%.0f avgCost=%.3f time=%.3f ms\n", algName, openName, heurName,
+                        solved, queries.size(), double(expansions) / n, solved ? costSum / double(solved) : 0.0, totalMS);
+            if (compare)
+                std::printf("          cost: %zu optimal, %zu longer (worst +%.4f, %.3f%%), %zu shorter than the file\n",
+                            optimal, longer, worst, 100.0 * worstRel, shorter);
+            std::printf("          latency: p50=%.1f p90=%.1f p99=%.1f max=%.1f us\n", percentile(latency, 0.5),
+                        percentile(latency, 0.9), percentile(latency, 0.99), latency.empty() ? 0.0 : latency.back());
+            if (o.cache > 0)
+                printCache(cache, totalMS, -1.0, queries.size());
+            if (solved != queries.size() || shorter > 0) rc = 3;
+        }
+    }
+    return rc;
+}
+
+} // namespace
+
+int main(int argc, const char* argv[])
+{
+    CliOptions o;
+    if (!parseArgs(argc, argv, o))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    maze::Grid grid;
+    unsigned seed = o.seed;
+    maze::ConnectivityIndex components;
+    auto landmarks = std::make_shared<maze::LandmarkTable>();
+    std::vector<maze::ScenarioQuery> scenario;
+    if (!o.scenPath.empty())
+    {
+        std::ifstream in(o.scenPath);
+        std::string mapName;
+        if (!in || !maze::readMovingAIScenario(in, scenario, &mapName))
+        {
+            std::fprintf(stderr, "cannot load scenario from '%s'\n", o.scenPath.c_str());
+            return 1;
+        }
+        if (o.loadPath.empty())
+            o.loadPath = scenarioMapPath(o.scenPath, mapName);
+    }
+    if (!o.loadPath.empty() && maze::isMazeFile(o.loadPath))
+    {
+        maze::MazeFileInfo info;
+        auto t0 = std::chrono::steady_clock::now();
+        if (!maze::loadMaze(o.loadPath, grid, &info, &components, landmarks.get()))
+        {
+            std::fprintf(stderr, "cannot load maze from '%s'\n", o.loadPath.c_str());
+            return 1;
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        if (info.seed) seed = info.seed;
+        std::printf("maze: %s (%dx%d, binary, mapped in %.3f ms%s%s)\n", o.loadPath.c_str(), grid.rows(), grid.cols(),
+                    std::chrono::duration<double, std::milli>(t1 - t0).count(), info.components ? ", with components" : "",
+                    info.landmarks ? ", with landmarks" : "");
+    }
+    else if (!o.loadPath.empty() && maze::isMovingAIMap(o.loadPath))
+    {
+        std::ifstream in(o.loadPath);
+        auto t0 = std::chrono::steady_clock::now();
+        if (!in || !maze::readMovingAIMap(in, grid))
+        {
+            std::fprintf(stderr, "cannot load maze from '%s'\n", o.loadPath.c_str());
+            return 1;
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        std::printf("maze: %s (%dx%d, MovingAI map, read in %.3f ms)\n", o.loadPath.c_str(), grid.rows(), grid.cols(),
+                    std::chrono::duration<double, std::milli>(t1 - t0).count());
+    }
+    else if (!o.loadPath.empty())
+    {
+        std::ifstream in(o.loadPath);
+        if (!in || !maze::readText(in, grid))
+        {
+            std::fprintf(stderr, "cannot load maze from '%s'\n", o.loadPath.c_str());
+            return 1;
+        }
+        std::printf("maze: %s (%dx%d)\n", o.loadPath.c_str(), grid.rows(), grid.cols());
+    }
+    else
+    {
+        grid.resize(o.rows, o.cols);
+        seed = maze::generate(grid, o.gen, o.seed);
+        std::printf("maze: generated %dx%d density=%.2f seed=%u\n", grid.rows(), grid.cols(), o.gen.density, seed);
+    }
+
+    if (o.connectivity)
+    {
+        const maze::Cell start = grid.start(), goal = grid.goal();
+        if (components.matches(grid, o.diagonal, o.corners))
+        {
+            std::printf("components: %zu, restored from the file; start and goal %s\n", components.componentCount(),
+                        components.connected(start, goal) ? "connected" : "NOT connected");
+        }
+        else
+        {
+            auto t0 = std::chrono::steady_clock::now();
+            components.build(grid, o.diagonal, o.corners);
+            auto t1 = std::chrono::steady_clock::now();
+            std::printf("components: %zu, %.1f MB, built in %.3f ms; start and goal %s\n", components.componentCount(),
+                        components.bytes() / 1048576.0, std::chrono::duration<double, std::milli>(t1 - t0).count(),
+                        components.connected(start, goal) ? "connected" : "NOT connected");
+        }
+    }
+
+    const bool wantLandmarks = std::find(o.heuristics.begin(), o.heuristics.end(), maze::HeuristicKind::Landmarks) != o.heuristics.end();
+    if (!o.savePath.empty())
+    {
+        if (saveBinary(o.savePath))
+        {
+            // store the tables the searches will use, so the next load skips building them
+            if (wantLandmarks && !landmarks->matches(grid, o.diagonal, o.corners, o.landmarks))
+            {
+                auto t0 = std::chrono::steady_clock::now();
+                landmarks->build(grid, o.diagonal, o.corners, o.landmarks);
+                auto t1 = std::chrono::steady_clock::now();
+                std::printf("landmarks: %d, %.1f MB, built in %.3f ms\n", landmarks->count(), landmarks->bytes() / 1048576.0,
+                            std::chrono::duration<double, std::milli>(t1 - t0).count());
+            }
+            maze::MazeFileExtras extras;
+            extras.seed = seed;
+            extras.components = o.connectivity ? &components : nullptr;
+            extras.landmarks = wantLandmarks ? landmarks.get() : nullptr;
+            if (!maze::saveMaze(o.savePath, grid, extras))
+            {
+                std::fprintf(stderr, "cannot save maze to '%s'\n", o.savePath.c_str());
+                return 1;
+            }
+        }
+        else
+        {
+            std::ofstream out(o.savePath);
+            maze::writeText(out, grid);
+            if (!out)
+            {
+                std::fprintf(stderr, "cannot save maze to '%s'\n", o.savePath.c_str());
+                return 1;
+            }
+        }
+    }
+
+    // loaded or saved tables for other options would only be replaced
+    if (!wantLandmarks || !landmarks->matches(grid, o.diagonal, o.corners, o.landmarks))
+        landmarks.reset();
+
+    if (!scenario.empty())
+        return runScenario(grid, o, scenario, o.connectivity ? &components : nullptr, landmarks);
+    if (o.queries > 0)
+        return runBatch(grid, o, seed ? seed : 1, o.connectivity ? &components : nullptr, landmarks);
+
+    maze::SearchEngine search(grid);
+    if (o.connectivity)
+        search.useConnectivity(&components);
+    if (landmarks)
+        search.useLandmarks(landmarks);
+    search.options().diagonal = o.diagonal;
+    search.options().corners = o.corners;
+    search.options().jumpTable = o.jumpTable;
+    search.options().clusterSize = o.clusterSize;
+    search.options().landmarks = o.landmarks;
+    search.recordTrace(o.trace);
+    maze::PathCache cache(std::size_t(o.cache));
+    if (o.cache > 0)
+        search.useCache(&cache);
+
+    int rc = 0;
+    for (auto alg : o.algorithms)
+    {
+        search.options().algorithm = alg;
+
+        // the open list does not matter for the BFS variants, D* Lite and HPA* (own heaps)
+        const bool fifo = (alg == maze::Algorithm::BFS || alg == maze::Algorithm::BidirectionalBFS);
+        const bool dstar = (alg == maze::Algorithm::DStarLite);
+        const bool hpa = (alg == maze::Algorithm::HPAStar);
+        std::size_t nOpen = (fifo || dstar || hpa) ? 1 : o.openLists.size();
+        std::size_t nHeur = maze::usesHeuristic(alg) ? o.heuristics.size() : 1;
+        for (std::size_t k = 0; k < nOpen * nHeur; k++)
+        {
+            search.options().openList = o.openLists[k / nHeur];
+            search.options().heuristic = o.heuristics[k % nHeur];
+            const char* openName = fifo ? "fifo" : dstar ? "indexed" : hpa ? "abstract" : maze::openListName(o.openLists[k / nHeur]);
+            const char* heurName = maze::usesHeuristic(alg) ? maze::heuristicName(o.heuristics[k % nHeur]) : "-";
+
+            if (alg == maze::Algorithm::JPS && o.jumpTable)
+            {
+                // build the JPS+ table outside the timed runs
+                auto t0 = std::chrono::steady_clock::now();
+                search.run();
+                auto t1 = std::chrono::steady_clock::now();
+                std::printf("jump table: %.1f MB, warm-up run (builds it if needed) %.3f ms\n", search.jumpTableBytes() / 1048576.0,
+                            std::chrono::duration<double, std::milli>(t1 - t0).count());
+            }
+            if (search.options().heuristic == maze::HeuristicKind::Landmarks && maze::usesHeuristic(alg) && !search.landmarks())
+            {
+                // the tables are built once and reused by every search
+                auto t0 = std::chrono::steady_clock::now();
+                search.prepareLandmarks();
+                auto t1 = std::chrono::steady_clock::now();
+                std::printf("landmarks: %d, %.1f MB, built in %.3f ms\n", search.landmarks()->count(),
+                            search.landmarks()->bytes() / 1048576.0, std::chrono::duration<double, std::milli>(t1 - t0).count());
+            }
+            if (hpa)
+            {
+                // the abstract graph is built once and reused by every query
+                auto t0 = std::chrono::steady_clock::now();
+                search.prepareHierarchy();
+                auto t1 = std::chrono::steady_clock::now();
+                const maze::PathHierarchy& h = *search.hierarchy();
+                std::printf("hierarchy: %zu clusters of %d, %u nodes, %zu edges, %.1f MB, built in %.3f ms\n",
+                            h.clusterCount(), h.clusterSize(), h.nodeCount(), h.edgeCount(), h.bytes() / 1048576.0,
+                            std::chrono::duration<double, std::milli>(t1 - t0).count());
+            }
+
+            cache.clear();
+            cache.resetStats();
+            double totalMS = 0, firstMS = 0;
+            bool solved = false;
+            for (int rep = 0; rep < o.repeat; rep++)
+            {
+                // time full searches; a kept D* Lite result would make repeats free
+                search.dropIncremental();
+                auto t0 = std::chrono::steady_clock::now();
+                solved = search.run();
+                auto t1 = std::chrono::steady_clock::now();
+                totalMS += std::chrono::duration<double, std::milli>(t1 - t0).count();
+                if (rep == 0) firstMS = totalMS;
+            }
+
+            std::printf("%-9s %-8s %-9s solved=%d visited=%zu expansions=%llu pushes=%llu stale=%llu peakOpen=%zu path=%zu cost=%.1f time=%.3f ms\n",
+                        (alg == maze::Algorithm::JPS && o.jumpTable) ? "JPS+" : maze::algorithmName(alg), openName, heurName,
+                        solved ? 1 : 0, search.visitedCount(),
+                        (unsigned long long)search.expansions(), (unsigned long long)search.pushes(),
+                        (unsigned long long)search.stalePops(), search.peakOpen(), search.pathLength(),
+                        solved ? search.pathCost() / maze::cCostScale : -1.0, totalMS / o.repeat);
+            if (o.trace)
+            {
+                const maze::SearchTrace& t = search.trace();
+                std::printf("          trace: %zu steps, %zu keyframes, %.1f KB (%.2f bytes/step)\n", t.steps(), t.keyframes(),
+                            t.bytes() / 1024.0, t.steps() ? double(t.bytes()) / double(t.steps()) : 0.0);
+            }
+            if (o.cache > 0)
+                printCache(cache, firstMS, o.repeat > 1 ? (totalMS - firstMS) / (o.repeat - 1) : -1.0, 1);
+            if (!solved) rc = 3;
+            if (dstar && o.replan > 0 && solved)
+                rc = std::max(rc, runReplan(grid, search, o, seed ? seed : 1, components));
+        }
+    }
+
+    if (o.print)
+        printSolved(grid, search);
+
+    return rc;
+}
@@ -0,0 +1,183 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include <cstddef>
+
+#include "Grid.h"
+#include "SearchEngine.h"
+#include "PathCache.h"
+#include "ThreadPool.h"
+
+namespace maze
+{
+
+struct Query
+{
+    Cell start;
+    Cell goal;
+};
+
+struct QueryResult
+{
+    bool solved = false;
+    long long cost = -1;            // -1 if not solved
+    std::size_t length = 0;         // cells on the path, 0 if not solved
+    std::vector<Cell> path;         // only filled when paths are kept
+};
+
+// Runs many start/goal queries against one read-only grid on a thread pool.
+// Every worker owns a SearchEngine, so the per-cell scratch is allocated once
+// per thread and reused for all of its queries. Queries are handed out in
+// small chunks through one atomic counter; results are written to their own
+// slots, so workers never share mutable state.
+//
+// The grid must not be modified while solve() runs.
+class BatchSolver
+{
+    static constexpr std::size_t cChunk = 16;
+
+    ThreadPool _pool;
+    std::vector<std::unique_ptr<SearchEngine>> _engines;   // one per worker
+    SearchEngine::Options _opt;
+    bool _keepPaths = true;
+
+    const Grid* _grid = nullptr;
+    std::size_t _gridCells = 0;
+    const ConnectivityIndex* _components = nullptr;
+    PathCache* _cache = nullptr;
+
+    // (Re)binds the per-worker engines when the grid or its size changed
+    void attach(const Grid& grid)
+    {
+        if (_grid == &grid && _gridCells == grid.size())
+            return;
+        _grid = &grid;
+        _gridCells = grid.size();
+        for (auto& e : _engines)
+            e->attach(grid);
+    }
+
+    bool validQuery(const Query& q) const
+    {
+        if (!_grid->inside(q.start) || !_grid->inside(q.goal) || _grid->isWall(q.start) || _grid->isWall(q.goal))
+            return false;
+        // known unreachable: no search at all
+        return !_components || !_components->matches(*_grid, _opt.diagonal, _opt.corners) || _components->connected(q.start, q.goal);
+    }
+
+public:
+    // threads == 0 uses one worker per hardware thread
+    explicit BatchSolver(unsigned threads = 0)
+        : _pool(threads)
+    {
+        _engines.reserve(_pool.size());
+        for (unsigned i = 0; i < _pool.size(); i++)
+            _engines.push_back(std::make_unique<SearchEngine>());
+    }
+
+    SearchEngine::Options& options() { return _opt; }
+    const SearchEngine::Options& options() const { return _opt; }
+
+    // Paths cost memory proportional to their length; disable to get lengths/costs only
+    void setKeepPaths(bool keep) { _keepPaths = keep; }
+    bool keepPaths() const { return _keepPaths; }
+
+    unsigned threadCount() const { return _pool.size(); }
+
+    // Connectivity index of the grid (not owned; nullptr = none). Queries
+    // between different components are reported unsolved without a search.
+    void setConnectivity(const ConnectivityIndex* index) { _components = index; }
+
+    // Path cache shared by all workers (not owned; nullptr = none). Repeated
+    // queries are answered from it; see PathCache.
+    void setCache(PathCache* cache)
+    {
+        _cache = cache;
+        for (auto& e : _engines)
+            e->useCache(cache);
+    }
+    PathCache* cache() const { return _cache; }
+
+    // ALT tables built or loaded elsewhere; used instead of building them if
+    // they match the grid and options
+    void useLandmarks(std::shared_ptr<LandmarkTable> table)
+    {
+        for (auto& e : _engines)
+            e->useLandmarks(table);
+    }
+
+    // Solves all queries; out[i] belongs to queries[i]. Queries with an
+    // endpoint outside the grid or on a wall, or known to be unreachable, are
+    // reported as unsolved.
+    void solve(const Grid& grid, const std::vector<Query>& queries, std::vector<QueryResult>& out)
+    {
+        attach(grid);
+        out.assign(queries.size(), QueryResult());
+        if (queries.empty())
+            return;
+
+        for (auto& e : _engines)
+            e->options() = _opt;
+
+        // JPS+: build the table once and let every worker read the same copy
+        if (_opt.algorithm == Algorithm::JPS && _opt.jumpTable)
+        {
+            _engines[0]->prepareJumpTable();
+            for (std::size_t i = 1; i < _engines.size(); i++)
+                _engines[i]->shareJumpTable(*_engines[0]);
+        }
+
+        // ALT: the same for the landmark tables
+        if (_opt.heuristic == HeuristicKind::Landmarks && usesHeuristic(_opt.algorithm))
+        {
+            _engines[0]->prepareLandmarks();
+            for (std::size_t i = 1; i < _engines.size(); i++)
+                _engines[i]->shareLandmarks(*_engines[0]);
+        }
+
+        // HPA*: the same for the abstract graph
+        if (_opt.algorithm == Algorithm::HPAStar)
+        {
+            _engines[0]->prepareHierarchy();
+            for (std::size_t i = 1; i < _engines.size(); i++)
+                _engines[i]->shareHierarchy(*_engines[0]);
+        }
+
+        std::atomic<std::size_t> next(0);
+        const std::size_t n = queries.size();
+        _pool.run([&](unsigned worker)
+        {
+            SearchEngine& search = *_engines[worker];
+            for (;;)
+            {
+                const std::size_t first = next.fetch_add(cChunk, std::memory_order_relaxed);
+                if (first >= n)
+                    break;
+                const std::size_t last = std::min(n, first + cChunk);
+                for (std::size_t i = first; i < last; i++)
+                {
+                    const Query& q = queries[i];
+                    if (!validQuery(q))
+                        continue;
+                    QueryResult& res = out[i];
+                    res.solved = search.run(q.start, q.goal);
+                    res.cost = search.pathCost();
+                    res.length = search.pathLength();
+                    if (_keepPaths)
+                        res.path = search.path();
+                }
+            }
+        });
+    }
+
+    std::vector<QueryResult> solve(const Grid& grid, const std::vector<Query>& queries)
+    {
+        std::vector<QueryResult> out;
+        solve(grid, queries, out);
+        return out;
+    }
+};
+
+} // namespace maze
@@ -0,0 +1,154 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+namespace maze
+{
+
+// 1 bit per cell wall mask (1 = wall). Every row is padded with a wall column
+// on both sides and the grid with a wall row above and below, so reading any
+// neighbor of an in-range cell never needs a bounds check. Each padded row also
+// carries one spare word so a 3-bit window can always read word and word+1.
+//
+// The words are either owned or a view of memory laid out the same way, such
+// as a mapped maze file (see MazeFile.h); copies always own their words.
+class BitGrid
+{
+    int _rows = 0;
+    int _cols = 0;
+    std::size_t _stride = 0;            // 64-bit words per padded row
+    std::vector<std::uint64_t> _words;  // owned words, empty for a view
+    std::uint64_t* _data = nullptr;     // _words.data() or the viewed words
+    std::shared_ptr<void> _owner;       // keeps viewed words alive
+
+    const std::uint64_t* paddedRow(int pr) const { return _data + std::size_t(pr) * _stride; }
+    std::uint64_t* paddedRow(int pr) { return _data + std::size_t(pr) * _stride; }
+
+    // 3 consecutive bits of padded row pr starting at padded column pc
+    static unsigned bits3(const std::uint64_t* row, std::size_t pc)
+    {
+        std::size_t w = pc >> 6;
+        unsigned off = unsigned(pc & 63);
+        std::uint64_t v = row[w] >> off;
+        if (off > 61)
+            v |= row[w+1] << (64 - off);
+        return unsigned(v & 7u);
+    }
+
+public:
+    static std::size_t strideFor(int cols) { return (std::size_t(cols) + 2 + 63) / 64 + 1; }
+    static std::size_t wordsFor(int rows, int cols) { return std::size_t(rows + 2) * strideFor(cols); }
+
+    BitGrid() = default;
+    BitGrid(const BitGrid& o)
+        : _rows(o._rows), _cols(o._cols), _stride(o._stride), _words(o._data, o._data + o.wordCount())
+    {
+        _data = _words.data();
+    }
+    BitGrid(BitGrid&& o) noexcept { swap(o); }
+    BitGrid& operator=(BitGrid o) noexcept
+    {
+        swap(o);
+        return *this;
+    }
+
+    void swap(BitGrid& o) noexcept
+    {
+        std::swap(_rows, o._rows);
+        std::swap(_cols, o._cols);
+        std::swap(_stride, o._stride);
+        _words.swap(o._words);
+        std::swap(_data, o._data);
+        _owner.swap(o._owner);
+    }
+
+    void resize(int rows, int cols)
+    {
+        _rows = rows;
+        _cols = cols;
+        _stride = strideFor(cols);
+        _owner.reset();
+        _words.assign(wordsFor(rows, cols), 0);
+        _data = _words.data();
+        // border
+        for (int pc = 0; pc < cols + 2; pc++)
+        {
+            setPadded(0, pc, true);
+            setPadded(rows + 1, pc, true);
+        }
+        for (int pr = 1; pr <= rows; pr++)
+        {
+            setPadded(pr, 0, true);
+            setPadded(pr, cols + 1, true);
+        }
+    }
+
+    // Uses words laid out as resize(rows, cols) lays them out, wall border
+    // included, without copying them; owner keeps them alive. Edits write to
+    // the viewed memory. False (and nothing changed) if the border is open.
+    bool view(int rows, int cols, std::uint64_t* words, std::shared_ptr<void> owner)
+    {
+        BitGrid v;
+        v._rows = rows;
+        v._cols = cols;
+        v._stride = strideFor(cols);
+        v._data = words;
+        v._owner = std::move(owner);
+        // reads one word per row; an open border would let searches leave the grid
+        for (int pc = 0; pc < cols + 2; pc++)
+            if (!v.getPadded(0, pc) || !v.getPadded(rows + 1, pc))
+                return false;
+        for (int pr = 1; pr <= rows; pr++)
+            if (!v.getPadded(pr, 0) || !v.getPadded(pr, cols + 1))
+                return false;
+        swap(v);
+        return true;
+    }
+
+    bool isView() const { return _owner != nullptr; }
+
+    int rows() const { return _rows; }
+    int cols() const { return _cols; }
+    std::size_t stride() const { return _stride; }
+    std::size_t wordCount() const { return _data ? std::size_t(_rows + 2) * _stride : 0; }
+    // All padded rows, wordCount() words
+    const std::uint64_t* words() const { return _data; }
+    std::size_t memoryBytes() const { return wordCount() * sizeof(std::uint64_t); }
+
+    bool getPadded(int pr, int pc) const
+    {
+        return (paddedRow(pr)[std::size_t(pc) >> 6] >> (pc & 63)) & 1u;
+    }
+
+    void setPadded(int pr, int pc, bool wall)
+    {
+        std::uint64_t& w = paddedRow(pr)[std::size_t(pc) >> 6];
+        std::uint64_t bit = std::uint64_t(1) << (pc & 63);
+        if (wall) w |= bit;
+        else w &= ~bit;
+    }
+
+    // r/c may be -1 or rows/cols (reads the wall border)
+    bool get(int r, int c) const { return getPadded(r + 1, c + 1); }
+    void set(int r, int c, bool wall) { setPadded(r + 1, c + 1, wall); }
+
+    // Wall bits of the 3x3 block centered at (r,c): bit (dr+1)*3 + (dc+1).
+    // Three word reads instead of eight bounds-checked byte loads.
+    unsigned walls3x3(int r, int c) const
+    {
+        std::size_t pc = std::size_t(c);   // padded column of c-1
+        return bits3(paddedRow(r), pc)
+            | (bits3(paddedRow(r + 1), pc) << 3)
+            | (bits3(paddedRow(r + 2), pc) << 6);
+    }
+
+    void clear()
+    {
+        resize(_rows, _cols);
+    }
+};
+
+} // namespace maze
@@ -0,0 +1,267 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "Grid.h"
+#include "MazeTypes.h"
+#include "Connectivity.h"
+
+namespace maze
+{
+
+// What a cell looks like; indexes the raster palette
+enum class Shade : std::uint8_t
+{
+    Free = 0,
+    Wall,
+    Visited,
+    Frontier,
+    Path,
+    BackVisited,    // backward side of bidirectional searches
+    BackFrontier,
+    Count
+};
+
+// RGBA texels (row-major, R in the lowest byte) for the visible window of the
+// grid, so a view shows it with a single scaled image draw instead of a
+// rectangle per cell.
+//
+// Only the window is rasterized: shades are derived on the fly from the wall
+// bits and the search state, so nothing proportional to the maze is stored
+// and a reset or pan costs in proportion to the visible area. At level of
+// detail k > 1 one texel covers a k x k block of cells and shows the block's
+// most important shade (path > frontier > visited > wall > free).
+//
+// Changed cells are queued with updateCell() and their texels recomputed once
+// by flush(); the bounding box of rewritten texels is kept so the view
+// uploads just that part.
+//
+// Search states are read from any source with the state(i) / isBackward(i)
+// interface: a SearchEngine, or a StateMirror fed by a SearchWorker.
+//
+// With a component overlay, free cells the search has not touched are tinted
+// by their connected component instead of drawn white.
+class CellRaster
+{
+public:
+    static constexpr std::uint32_t rgba(std::uint8_t r, std::uint8_t g, std::uint8_t b, std::uint8_t a = 255)
+    {
+        return std::uint32_t(r) | (std::uint32_t(g) << 8) | (std::uint32_t(b) << 16) | (std::uint32_t(a) << 24);
+    }
+
+    // Inclusive texel range; empty if r0 > r1
+    struct Region
+    {
+        int r0 = 1, c0 = 1, r1 = 0, c1 = 0;
+        bool empty() const { return r0 > r1; }
+    };
+
+private:
+    std::uint32_t _palette[std::size_t(Shade::Count)] = {
+        rgba(255, 255, 255), rgba(0, 0, 0), rgba(255, 255, 0), rgba(0, 255, 255),
+        rgba(0, 128, 0), rgba(255, 165, 0), rgba(255, 0, 255)};
+
+    // Window: texel (0,0) covers cells from (_row0, _col0); each texel lod x lod cells
+    int _lod = 1;
+    int _row0 = 0;
+    int _col0 = 0;
+    int _texRows = 0;
+    int _texCols = 0;
+    std::vector<std::uint32_t> _pixels;
+
+    std::vector<std::uint8_t> _queued;      // per texel: already in _pending
+    std::vector<std::uint32_t> _pending;    // texels to recompute in flush()
+    Region _dirty;
+
+    const ConnectivityIndex* _components = nullptr;
+
+    // Merge priority of each Shade when a texel covers several cells
+    static int rank(Shade s)
+    {
+        static constexpr int cRank[std::size_t(Shade::Count)] = {0, 1, 3, 5, 6, 2, 4};
+        return cRank[std::size_t(s)];
+    }
+
+    void touch(int r, int c)
+    {
+        if (_dirty.empty())
+        {
+            _dirty = {r, c, r, c};
+            return;
+        }
+        _dirty.r0 = std::min(_dirty.r0, r);
+        _dirty.r1 = std::max(_dirty.r1, r);
+        _dirty.c0 = std::min(_dirty.c0, c);
+        _dirty.c1 = std::max(_dirty.c1, c);
+    }
+
+    // Pastel color of a component id
+    static std::uint32_t componentColor(std::uint32_t id)
+    {
+        const std::uint32_t h = id * 2654435761u;
+        return rgba(std::uint8_t(128 + ((h >> 8) & 0x7F)), std::uint8_t(128 + ((h >> 16) & 0x7F)),
+                    std::uint8_t(128 + ((h >> 24) & 0x7F)));
+    }
+
+    // A free shade is tinted by the component of cell i under the overlay
+    std::uint32_t colorOf(Shade s, const Grid& grid, std::size_t i) const
+    {
+        if (s == Shade::Free && _components && _components->matches(grid))
+            return componentColor(_components->component(i));
+        return _palette[std::size_t(s)];
+    }
+
+    template <class States>
+    std::uint32_t texel(const Grid& grid, const States& search, int tr, int tc) const
+    {
+        const int r0 = _row0 + tr * _lod, c0 = _col0 + tc * _lod;
+        if (_lod == 1)
+        {
+            const std::size_t i = grid.index(r0, c0);
+            return colorOf(shadeOf(grid, search, i), grid, i);
+        }
+
+        const int r1 = std::min(grid.rows(), r0 + _lod), c1 = std::min(grid.cols(), c0 + _lod);
+        Shade best = Shade::Free;
+        std::size_t firstFree = cNoCell;
+        for (int r = r0; r < r1; r++)
+        {
+            for (int c = c0; c < c1; c++)
+            {
+                const std::size_t i = grid.index(r, c);
+                Shade s = shadeOf(grid, search, i);
+                if (s == Shade::Free && firstFree == cNoCell)
+                    firstFree = i;
+                if (rank(s) > rank(best))
+                {
+                    best = s;
+                    if (best == Shade::Path)
+                        return _palette[std::size_t(best)];
+                }
+            }
+        }
+        return colorOf(best, grid, firstFree);
+    }
+
+public:
+    template <class States>
+    static Shade shadeOf(const Grid& grid, const States& search, std::size_t i)
+    {
+        if (grid.isWall(i)) return Shade::Wall;
+        const bool back = search.isBackward(i);
+        switch (search.state(i))
+        {
+            case CellState::Visited:  return back ? Shade::BackVisited : Shade::Visited;
+            case CellState::Frontier: return back ? Shade::BackFrontier : Shade::Frontier;
+            case CellState::Path:     return Shade::Path;
+            default:                  return Shade::Free;
+        }
+    }
+
+    // Window geometry
+    int lod() const { return _lod; }
+    int firstRow() const { return _row0; }
+    int firstCol() const { return _col0; }
+    int texRows() const { return _texRows; }
+    int texCols() const { return _texCols; }
+    std::size_t texelCount() const { return _pixels.size(); }
+
+    const std::uint32_t* pixels() const { return _pixels.data(); }
+    std::size_t strideBytes() const { return std::size_t(_texCols) * sizeof(std::uint32_t); }
+
+    // Returns true if the color changed (the window then needs render())
+    bool setPalette(Shade s, std::uint32_t color)
+    {
+        std::uint32_t& p = _palette[std::size_t(s)];
+        if (p == color) return false;
+        p = color;
+        return true;
+    }
+
+    // Tints free cells by component (nullptr = off). Returns true if the
+    // setting changed (the window then needs render()).
+    bool setOverlay(const ConnectivityIndex* components)
+    {
+        if (_components == components) return false;
+        _components = components;
+        return true;
+    }
+
+    // Selects the cells [r0..r1] x [c0..c1] at level of detail lod; the start
+    // is aligned down to a multiple of lod. Returns true if the window changed
+    // (the texels are then stale until render()).
+    bool setWindow(int r0, int c0, int r1, int c1, int lod)
+    {
+        lod = std::max(1, lod);
+        r0 -= r0 % lod;
+        c0 -= c0 % lod;
+        const int texRows = std::max(0, (r1 - r0) / lod + 1);
+        const int texCols = std::max(0, (c1 - c0) / lod + 1);
+        if (lod == _lod && r0 == _row0 && c0 == _col0 && texRows == _texRows && texCols == _texCols)
+            return false;
+
+        _lod = lod;
+        _row0 = r0;
+        _col0 = c0;
+        _texRows = texRows;
+        _texCols = texCols;
+        _pixels.assign(std::size_t(texRows) * std::size_t(texCols), 0);
+        _queued.assign(_pixels.size(), 0);
+        _pending.clear();
+        return true;
+    }
+
+    // Recomputes every texel of the window
+    template <class States>
+    void render(const Grid& grid, const States& search)
+    {
+        for (int tr = 0; tr < _texRows; tr++)
+            for (int tc = 0; tc < _texCols; tc++)
+                _pixels[std::size_t(tr) * _texCols + tc] = texel(grid, search, tr, tc);
+        for (std::uint32_t t : _pending)
+            _queued[t] = 0;
+        _pending.clear();
+        if (!_pixels.empty())
+            _dirty = {0, 0, _texRows - 1, _texCols - 1};
+    }
+
+    // Queues the texel covering cell (r, c) if it is inside the window
+    void updateCell(int r, int c)
+    {
+        const int tr = (r - _row0) / _lod, tc = (c - _col0) / _lod;
+        if (r < _row0 || c < _col0 || tr >= _texRows || tc >= _texCols)
+            return;
+        const std::uint32_t t = std::uint32_t(tr * _texCols + tc);
+        if (_queued[t]) return;
+        _queued[t] = 1;
+        _pending.push_back(t);
+    }
+
+    // Recomputes the queued texels
+    template <class States>
+    void flush(const Grid& grid, const States& search)
+    {
+        for (std::uint32_t t : _pending)
+        {
+            _queued[t] = 0;
+            const int tr = int(t) / _texCols, tc = int(t) % _texCols;
+            const std::uint32_t color = texel(grid, search, tr, tc);
+            if (_pixels[t] == color) continue;
+            _pixels[t] = color;
+            touch(tr, tc);
+        }
+        _pending.clear();
+    }
+
+    // Texels rewritten since the last call
+    Region takeDirty()
+    {
+        Region d = _dirty;
+        _dirty = Region();
+        return d;
+    }
+};
+
+} // namespace maze
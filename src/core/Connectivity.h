@@ -0,0 +1,440 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+
+#include "Grid.h"
+#include "MazeTypes.h"
+
+namespace maze
+{
+
+// Connected components of the free cells, for the movement model of the
+// search. Only 8-connectivity with corner cutting joins cells that
+// 4-connectivity does not: under the stricter corner rules a diagonal move
+// is allowed only next to a free cell that links the two ends orthogonally. Two cells are connected iff
+// component() returns the same id for both, so a query between different
+// components is known to have no path without searching.
+//
+// Every free cell stores a label; labels are merged with union-find (by size,
+// so finds stay short without path compression and queries are const and
+// safe to run from several threads). build() labels the grid in one
+// row-major pass. Edits are applied with wallChanged():
+//   - a cell opened gets a new label joined with its neighbours' sets;
+//   - a cell closed can only split its set if its free neighbours are not
+//     already connected around it. Then one breadth-first search per
+//     neighbour group runs interleaved, a cell at a time, until all but one
+//     group has either met another or run out of cells; those that ran out
+//     are new components and only their cells are relabeled. The work is
+//     proportional to the smaller side of the split.
+//
+// Memory: 4 bytes per cell for labels, 5 more once a wall has been added.
+class ConnectivityIndex
+{
+public:
+    static constexpr std::uint32_t cNone = 0xFFFFFFFFu;
+
+private:
+    // Labels handed out by edits before build() compacts them again
+    static constexpr std::size_t cIdSlack = 4096;
+
+    const Grid* _grid = nullptr;
+    bool _diagonal = false;
+    bool _valid = false;
+    std::uint64_t _version = 0;             // edit count, for wallChanged()
+    std::uint64_t _generation = 0;          // Grid::generation() it describes
+
+    std::vector<std::uint32_t> _label;      // per cell: a member id of its set, cNone for walls
+    std::vector<std::uint32_t> _parent;     // union-find over ids
+    std::vector<std::uint32_t> _size;       // free cells per root id
+    std::size_t _components = 0;
+
+    // Split scratch
+    std::vector<std::uint32_t> _seen;       // per cell: stamp of the split that reached it
+    std::vector<std::uint8_t> _who;         // per cell: group that reached it
+    std::uint32_t _stamp = 0;
+    struct Probe
+    {
+        std::vector<CellIndex> cells;       // reached cells, in BFS order
+        std::size_t head = 0;
+    };
+    Probe _probes[4];
+
+    // Ring around a cell, in order: NW, N, NE, E, SE, S, SW, W
+    static constexpr int cRingR[8] = {-1, -1, -1, 0, 1, 1, 1, 0};
+    static constexpr int cRingC[8] = {-1, 0, 1, 1, 1, 0, -1, -1};
+
+    std::uint32_t newId(std::uint32_t size)
+    {
+        _parent.push_back(std::uint32_t(_parent.size()));
+        _size.push_back(size);
+        _components++;
+        return std::uint32_t(_parent.size() - 1);
+    }
+
+    // Components are 8-connected only if diagonals may cut corners
+    static bool cutsCorners(bool diagonal, CornerRule corners) { return diagonal && corners == CornerRule::Cut; }
+
+    std::uint32_t find(std::uint32_t id) const
+    {
+        while (_parent[id] != id)
+            id = _parent[id];
+        return id;
+    }
+
+    void unite(std::uint32_t a, std::uint32_t b)
+    {
+        a = find(a);
+        b = find(b);
+        if (a == b) return;
+        if (_size[a] < _size[b]) std::swap(a, b);
+        _parent[b] = a;
+        _size[a] += _size[b];
+        _components--;
+    }
+
+    // Calls fn(neighbourIndex) for every free neighbour of the cell
+    template <class Fn>
+    void forNeighbors(Cell cell, Fn&& fn) const
+    {
+        const unsigned walls = _grid->walls3x3(cell.r, cell.c);
+        const int nDirs = _diagonal ? 8 : 4;
+        for (int dir = 0; dir < nDirs; dir++)
+            if (!(walls & (1u << cDirBit[dir])))
+                fn(_grid->index(cell.r + cDirR[dir], cell.c + cDirC[dir]));
+    }
+
+    void addCell(std::size_t i)
+    {
+        const std::uint32_t id = newId(1);
+        _label[i] = id;
+        forNeighbors(_grid->cellAt(i), [&](std::size_t n) { unite(id, _label[n]); });
+    }
+
+    void removeCell(std::size_t i)
+    {
+        const Cell cell = _grid->cellAt(i);
+        const std::uint32_t root = find(_label[i]);
+        _label[i] = cNone;
+        if (--_size[root] == 0)
+        {
+            _components--;
+            return;
+        }
+
+        // group the free ring cells that are connected without the center
+        bool open[8];
+        int group[8];
+        for (int k = 0; k < 8; k++)
+        {
+            open[k] = !_grid->isWall(cell.r + cRingR[k], cell.c + cRingC[k]);
+            group[k] = k;
+        }
+        for (int a = 0; a < 8; a++)
+        {
+            for (int b = a + 1; b < 8; b++)
+            {
+                const int dr = std::abs(cRingR[a] - cRingR[b]), dc = std::abs(cRingC[a] - cRingC[b]);
+                const bool adjacent = _diagonal ? (dr <= 1 && dc <= 1) : (dr + dc == 1);
+                if (!open[a] || !open[b] || !adjacent) continue;
+                const int from = group[b], to = group[a];
+                for (int k = 0; k < 8; k++)
+                    if (group[k] == from) group[k] = to;
+            }
+        }
+
+        // one seed per group that holds a neighbour of the center
+        CellIndex seeds[4];
+        int seedGroup[4];
+        int nSeeds = 0;
+        for (int k = 0; k < 8; k++)
+        {
+            const bool neighbour = _diagonal || cRingR[k] == 0 || cRingC[k] == 0;
+            if (!open[k] || !neighbour) continue;
+            bool known = false;
+            for (int s = 0; s < nSeeds; s++)
+                known |= (seedGroup[s] == group[k]);
+            if (known) continue;
+            seedGroup[nSeeds] = group[k];
+            seeds[nSeeds++] = CellIndex(_grid->index(cell.r + cRingR[k], cell.c + cRingC[k]));
+        }
+        if (nSeeds > 1)
+            split(root, seeds, nSeeds);
+    }
+
+    // Interleaved BFS from the seeds; seeds whose search runs dry before
+    // meeting the others become components of their own
+    void split(std::uint32_t root, const CellIndex* seeds, int nSeeds)
+    {
+        if (_seen.size() != _label.size())
+        {
+            _seen.assign(_label.size(), 0);
+            _who.assign(_label.size(), 0);
+            _stamp = 0;
+        }
+        if (++_stamp == 0)
+        {
+            std::fill(_seen.begin(), _seen.end(), 0);
+            _stamp = 1;
+        }
+
+        int set[4];                         // union-find over the seeds
+        bool resolved[4] = {};
+        auto setOf = [&](int s) { while (set[s] != s) s = set[s]; return s; };
+        for (int s = 0; s < nSeeds; s++)
+        {
+            set[s] = s;
+            _probes[s].cells.assign(1, seeds[s]);
+            _probes[s].head = 0;
+            _seen[seeds[s]] = _stamp;
+            _who[seeds[s]] = std::uint8_t(s);
+        }
+
+        int open = nSeeds;                  // sets neither merged away nor resolved
+        while (open > 1)
+        {
+            for (int s = 0; s < nSeeds && open > 1; s++)
+            {
+                const int owner = setOf(s);
+                if (resolved[owner]) continue;
+                Probe& p = _probes[s];
+                if (p.head == p.cells.size())
+                {
+                    // the set is closed once none of its probes can grow
+                    bool dry = true;
+                    for (int t = 0; t < nSeeds; t++)
+                        if (setOf(t) == owner && _probes[t].head < _probes[t].cells.size())
+                            dry = false;
+                    if (!dry) continue;
+
+                    std::uint32_t n = 0;
+                    for (int t = 0; t < nSeeds; t++)
+                        if (setOf(t) == owner)
+                            n += std::uint32_t(_probes[t].cells.size());
+                    const std::uint32_t id = newId(n);
+                    for (int t = 0; t < nSeeds; t++)
+                        if (setOf(t) == owner)
+                            for (CellIndex c : _probes[t].cells)
+                                _label[c] = id;
+                    _size[root] -= n;
+                    resolved[owner] = true;
+                    open--;
+                    continue;
+                }
+
+                const CellIndex cur = p.cells[p.head++];
+                forNeighbors(_grid->cellAt(cur), [&](std::size_t n)
+                {
+                    if (_seen[n] != _stamp)
+                    {
+                        _seen[n] = _stamp;
+                        _who[n] = std::uint8_t(s);
+                        p.cells.push_back(CellIndex(n));
+                        return;
+                    }
+                    const int other = setOf(_who[n]);
+                    const int mine = setOf(s);
+                    if (other != mine)
+                    {
+                        set[other] = mine;
+                        open--;
+                    }
+                });
+            }
+        }
+
+        for (int s = 0; s < nSeeds; s++)
+        {
+            std::vector<CellIndex>().swap(_probes[s].cells);
+            _probes[s].head = 0;
+        }
+    }
+
+public:
+    // Labels every free cell of the grid for the given movement model
+    void build(const Grid& grid, bool diagonal, CornerRule corners = CornerRule::Cut)
+    {
+        _grid = &grid;
+        _diagonal = cutsCorners(diagonal, corners);
+        _version = grid.version();
+        _generation = grid.generation();
+        _valid = true;
+
+        const int rows = grid.rows(), cols = grid.cols();
+        _label.assign(grid.size(), cNone);
+        _parent.clear();
+        _size.clear();
+        _components = 0;
+
+        // join each cell with the neighbours already labeled: W, N (and NW, NE)
+        static constexpr int cBack[4] = {2, 0, 4, 5};
+        const int nBack = _diagonal ? 4 : 2;
+        for (int r = 0; r < rows; r++)
+        {
+            for (int c = 0; c < cols; c++)
+            {
+                if (grid.isWall(r, c)) continue;
+                const std::size_t i = grid.index(r, c);
+                const unsigned walls = grid.walls3x3(r, c);
+                std::uint32_t id = cNone;
+                for (int k = 0; k < nBack; k++)
+                {
+                    const int dir = cBack[k];
+                    if (walls & (1u << cDirBit[dir])) continue;
+                    const std::uint32_t n = _label[grid.index(r + cDirR[dir], c + cDirC[dir])];
+                    if (id == cNone) id = n;
+                    else unite(id, n);
+                }
+                if (id == cNone)
+                    id = newId(0);
+                _label[i] = id;
+                _size[find(id)]++;
+            }
+        }
+
+        // compact: one id per component, every label its root
+        std::vector<std::uint32_t> dense(_parent.size(), cNone);
+        std::uint32_t count = 0;
+        for (std::uint32_t& l : _label)
+        {
+            if (l == cNone) continue;
+            const std::uint32_t root = find(l);
+            if (dense[root] == cNone) dense[root] = count++;
+            l = dense[root];
+        }
+        std::vector<std::uint32_t> size(count, 0);
+        for (std::uint32_t l : _label)
+            if (l != cNone) size[l]++;
+        _size.swap(size);
+        _parent.resize(count);
+        for (std::uint32_t k = 0; k < count; k++)
+            _parent[k] = k;
+        _components = count;
+    }
+
+    // True if the index describes this grid as it is now, for this movement model
+    bool matches(const Grid& grid, bool diagonal, CornerRule corners = CornerRule::Cut) const
+    {
+        return matches(grid) && _diagonal == cutsCorners(diagonal, corners);
+    }
+
+    // Same, for whichever movement model the index was built for
+    bool matches(const Grid& grid) const
+    {
+        return _valid && _grid == &grid && _generation == grid.generation() && _label.size() == grid.size();
+    }
+
+    // The wall at cell was toggled; call right after each edit. Any other grid
+    // change in between makes the index stale until the next build().
+    void wallChanged(Cell cell)
+    {
+        if (!_valid) return;
+        if (_grid->version() != _version + 1 || !_grid->inside(cell) || _label.size() != _grid->size())
+        {
+            _valid = false;
+            return;
+        }
+        _version = _grid->version();
+        _generation = _grid->generation();
+
+        const std::size_t i = _grid->index(cell);
+        if (_grid->isWall(cell))
+        {
+            if (_label[i] != cNone) removeCell(i);
+        }
+        else if (_label[i] == cNone)
+            addCell(i);
+
+        if (_parent.size() > _label.size() + cIdSlack)
+            build(*_grid, _diagonal);
+    }
+
+    // Drops all memory; matches() is false until the next build()
+    void release()
+    {
+        *this = ConnectivityIndex();
+    }
+
+    // Component id per cell numbered 0 .. componentCount() - 1, cNone for
+    // walls: what restore() takes back
+    void denseLabels(std::vector<std::uint32_t>& out) const
+    {
+        std::vector<std::uint32_t> dense(_parent.size(), cNone);
+        std::uint32_t count = 0;
+        out.resize(_label.size());
+        for (std::size_t i = 0; i < _label.size(); i++)
+        {
+            if (_label[i] == cNone)
+            {
+                out[i] = cNone;
+                continue;
+            }
+            const std::uint32_t root = find(_label[i]);
+            if (dense[root] == cNone) dense[root] = count++;
+            out[i] = dense[root];
+        }
+    }
+
+    // Takes over labels from denseLabels() for the grid as it is now, instead
+    // of build(). eightConnected is diagonal() of the saved index. False (and
+    // the index invalid) if the labels do not fit the grid's walls.
+    bool restore(const Grid& grid, bool eightConnected, const std::uint32_t* labels, std::size_t count)
+    {
+        release();
+        _label.assign(labels, labels + grid.size());
+        _size.assign(count, 0);
+        std::size_t i = 0;
+        for (int r = 0; r < grid.rows(); r++)
+        {
+            for (int c = 0; c < grid.cols(); c++, i++)
+            {
+                const std::uint32_t l = _label[i];
+                if ((l == cNone) != grid.isWall(r, c) || (l != cNone && l >= count))
+                {
+                    release();
+                    return false;
+                }
+                if (l != cNone) _size[l]++;
+            }
+        }
+        _parent.resize(count);
+        for (std::uint32_t k = 0; k < count; k++)
+            _parent[k] = k;
+        _components = count;
+        _grid = &grid;
+        _diagonal = eightConnected;
+        _version = grid.version();
+        _generation = grid.generation();
+        _valid = true;
+        return true;
+    }
+
+    // Component id of cell i, cNone for walls; ids change when edits merge or split components
+    std::uint32_t component(std::size_t i) const
+    {
+        const std::uint32_t l = _label[i];
+        return l == cNone ? cNone : find(l);
+    }
+
+    bool connected(Cell a, Cell b) const
+    {
+        const std::uint32_t ca = component(_grid->index(a));
+        return ca != cNone && ca == component(_grid->index(b));
+    }
+
+    // True if the components are 8-connected
+    bool diagonal() const { return _diagonal; }
+    std::size_t componentCount() const { return _components; }
+    // Free cells in the component with the given id
+    std::size_t componentSize(std::uint32_t id) const { return _size[find(id)]; }
+
+    std::size_t bytes() const
+    {
+        return (_label.capacity() + _parent.capacity() + _size.capacity() + _seen.capacity()) * sizeof(std::uint32_t) +
+               _who.capacity();
+    }
+};
+
+} // namespace maze
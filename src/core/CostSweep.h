@@ -0,0 +1,109 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "Grid.h"
+#include "MazeTypes.h"
+
+namespace maze
+{
+
+// Exact path costs from one cell to every cell it reaches, for a movement
+// model. Plain Dijkstra with a ring of buckets instead of a heap: the move
+// costs are small integers, so cell costs only grow in steps of 10 or 14.
+// Optionally records, per cell, the direction of the move that reached it,
+// which makes the result a shortest-path tree rooted at the source.
+class CostSweep
+{
+public:
+    static constexpr std::uint32_t cInf = 0xFFFFFFFFu;
+    static constexpr std::int8_t cNoDir = -1;
+
+private:
+    std::vector<std::uint32_t> _g;
+    std::vector<std::uint32_t> _ring[cDiagCost + 1];
+
+    static constexpr std::size_t cCancelMask = 4095;    // cells between checks of the cancel flag
+
+    template <bool Diagonal, CornerRule Rule>
+    bool sweep(const Grid& grid, Cell src, std::int8_t* dirs, CancelFlag cancel)
+    {
+        constexpr std::uint32_t cRing = cDiagCost + 1;
+        std::fill(_g.begin(), _g.end(), cInf);
+        for (auto& bucket : _ring)
+            bucket.clear();
+
+        std::size_t pending = 1, popped = 0;
+        _g[grid.index(src)] = 0;
+        _ring[0].push_back(std::uint32_t(grid.index(src)));
+        for (std::uint32_t g = 0; pending > 0; g++)
+        {
+            std::vector<std::uint32_t>& bucket = _ring[g % cRing];
+            for (std::size_t k = 0; k < bucket.size(); k++)
+            {
+                const std::size_t i = bucket[k];
+                pending--;
+                if ((++popped & cCancelMask) == 0 && cancelled(cancel)) return false;
+                if (_g[i] != g) continue;   // settled earlier at a lower cost
+                const Cell cell = grid.cellAt(i);
+                const unsigned walls = grid.walls3x3(cell.r, cell.c);
+                for (int dir = 0; dir < (Diagonal ? 8 : 4); dir++)
+                {
+                    if (!canMove<Rule>(walls, dir)) continue;
+                    const std::size_t ni = grid.index(cell.r + cDirR[dir], cell.c + cDirC[dir]);
+                    const std::uint32_t ng = g + stepCost(dir);
+                    if (ng >= _g[ni]) continue;
+                    _g[ni] = ng;
+                    if (dirs) dirs[ni] = std::int8_t(dir);
+                    _ring[ng % cRing].push_back(std::uint32_t(ni));
+                    pending++;
+                }
+            }
+            bucket.clear();
+        }
+        return true;
+    }
+
+public:
+    // Measures the path costs from src. If dirs is given it is resized to the
+    // grid and filled with the direction each cell was reached by (cNoDir for
+    // src and for cells src cannot reach). False if cancelled part way, with
+    // the costs incomplete.
+    bool run(const Grid& grid, Cell src, bool diagonal, CornerRule corners, std::vector<std::int8_t>* dirs = nullptr,
+             CancelFlag cancel = nullptr)
+    {
+        _g.resize(grid.size());
+        std::int8_t* d = nullptr;
+        if (dirs)
+        {
+            dirs->assign(grid.size(), cNoDir);
+            d = dirs->data();
+        }
+        if (!diagonal) return sweep<false, CornerRule::Cut>(grid, src, d, cancel);
+        switch (corners)
+        {
+            case CornerRule::NoCut:     return sweep<true, CornerRule::NoCut>(grid, src, d, cancel);
+            case CornerRule::NoSqueeze: return sweep<true, CornerRule::NoSqueeze>(grid, src, d, cancel);
+            case CornerRule::Cut:
+            default:                    return sweep<true, CornerRule::Cut>(grid, src, d, cancel);
+        }
+    }
+
+    // Path cost from the last source per row-major cell index (cInf = unreached)
+    const std::vector<std::uint32_t>& costs() const { return _g; }
+
+    void release()
+    {
+        _g.clear();
+        _g.shrink_to_fit();
+        for (auto& bucket : _ring)
+        {
+            bucket.clear();
+            bucket.shrink_to_fit();
+        }
+    }
+};
+
+} // namespace maze
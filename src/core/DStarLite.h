@@ -0,0 +1,351 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+
+#include "Grid.h"
+#include "MazeTypes.h"
+
+namespace maze
+{
+
+// D* Lite (Koenig & Likhachev): LPA* rooted at the goal, so g(s) is the cost
+// from s to the goal. g and rhs survive between searches; after walls change
+// (reported with wallChanged()) or the start moves, the next search only
+// repairs the vertices whose values the change invalidated instead of
+// searching from scratch. A new goal, neighborhood (diagonal setting or
+// corner rule) or an unreported grid change (grid version mismatch) starts
+// over. The heuristic is fixed to the consistent one for the neighborhood
+// (Manhattan or octile), which the key modifier km relies on.
+//
+// The priority queue is an indexed binary heap over cells, keyed by the pair
+// [min(g,rhs) + h(start,s) + km, min(g,rhs)] packed into one 64-bit integer.
+// Memory: g, rhs and a heap position per cell (12 bytes), allocated on first
+// use.
+class DStarLite
+{
+public:
+    static constexpr std::uint32_t cInf = 0xFFFFFFFFu;
+
+private:
+    static constexpr std::uint32_t cNotQueued = 0xFFFFFFFFu;
+
+    const Grid* _grid = nullptr;
+    bool _diagonal = false;
+    CornerRule _corners = CornerRule::Cut;
+    bool _valid = false;                // g/rhs belong to _goal on this grid
+    std::uint64_t _version = 0;         // grid edit count, for wallChanged()
+    std::uint64_t _generation = 0;      // Grid::generation() g/rhs are consistent with
+
+    std::vector<std::uint32_t> _g;
+    std::vector<std::uint32_t> _rhs;
+    std::vector<std::uint32_t> _pos;    // heap slot per cell, cNotQueued if not queued
+
+    struct Entry
+    {
+        std::uint64_t key;
+        CellIndex cell;
+    };
+    std::vector<Entry> _heap;
+
+    Cell _start;
+    Cell _goal;
+    Cell _last;                         // start when km was last updated
+    std::uint32_t _km = 0;
+
+    // ----- heap -----
+    void place(std::size_t slot, const Entry& e)
+    {
+        _heap[slot] = e;
+        _pos[e.cell] = std::uint32_t(slot);
+    }
+
+    void siftUp(std::size_t slot)
+    {
+        const Entry e = _heap[slot];
+        while (slot > 0)
+        {
+            const std::size_t parent = (slot - 1) / 2;
+            if (_heap[parent].key <= e.key) break;
+            place(slot, _heap[parent]);
+            slot = parent;
+        }
+        place(slot, e);
+    }
+
+    void siftDown(std::size_t slot)
+    {
+        const Entry e = _heap[slot];
+        const std::size_t n = _heap.size();
+        for (;;)
+        {
+            std::size_t child = 2 * slot + 1;
+            if (child >= n) break;
+            if (child + 1 < n && _heap[child + 1].key < _heap[child].key) child++;
+            if (e.key <= _heap[child].key) break;
+            place(slot, _heap[child]);
+            slot = child;
+        }
+        place(slot, e);
+    }
+
+    void heapSet(std::size_t i, std::uint64_t key)
+    {
+        const std::uint32_t slot = _pos[i];
+        if (slot == cNotQueued)
+        {
+            _heap.push_back({key, CellIndex(i)});
+            siftUp(_heap.size() - 1);
+            return;
+        }
+        const std::uint64_t old = _heap[slot].key;
+        _heap[slot].key = key;
+        if (key < old) siftUp(slot);
+        else siftDown(slot);
+    }
+
+    void heapRemove(std::size_t i)
+    {
+        const std::uint32_t slot = _pos[i];
+        if (slot == cNotQueued) return;
+        _pos[i] = cNotQueued;
+        const Entry last = _heap.back();
+        _heap.pop_back();
+        if (slot == _heap.size()) return;
+        place(slot, last);
+        siftUp(slot);
+        siftDown(_pos[last.cell]);
+    }
+
+    // ----- D* Lite -----
+    std::uint32_t distance(int r, int c, const Cell& to) const
+    {
+        const int dr = std::abs(r - to.r), dc = std::abs(c - to.c);
+        return _diagonal ? octileCost(dr, dc) : manhattanCost(dr, dc);
+    }
+
+    std::uint32_t h(int r, int c) const { return distance(r, c, _start); }
+
+    std::uint64_t calcKey(std::size_t i) const
+    {
+        const std::uint32_t m = std::min(_g[i], _rhs[i]);
+        if (m == cInf)
+            return ~std::uint64_t(0);
+        const Cell cell = _grid->cellAt(i);
+        return (std::uint64_t(m + h(cell.r, cell.c) + _km) << 32) | m;
+    }
+
+    static std::uint32_t add(std::uint32_t g, std::uint32_t c) { return g == cInf ? cInf : g + c; }
+
+    // Calls fn(neighborIndex, moveCost) for every neighbor a free cell can
+    // move to; moves are symmetric under every corner rule
+    template <class Fn>
+    void forNeighbors(std::size_t i, Fn&& fn) const
+    {
+        const Cell cell = _grid->cellAt(i);
+        if (_grid->isWall(cell)) return;
+        const unsigned walls = _grid->walls3x3(cell.r, cell.c);
+        const int nDirs = _diagonal ? 8 : 4;
+        for (int dir = 0; dir < nDirs; dir++)
+            if (canMove(walls, dir, _corners))
+                fn(_grid->index(cell.r + cDirR[dir], cell.c + cDirC[dir]), stepCost(dir));
+    }
+
+    std::uint32_t minSucc(std::size_t i) const
+    {
+        std::uint32_t best = cInf;
+        forNeighbors(i, [&](std::size_t n, std::uint32_t cost) { best = std::min(best, add(_g[n], cost)); });
+        return best;
+    }
+
+    // Requeues i if inconsistent; onQueue(i) when it enters the queue
+    template <class OnQueue>
+    void updateVertex(std::size_t i, OnQueue&& onQueue)
+    {
+        if (_g[i] != _rhs[i])
+        {
+            if (_pos[i] == cNotQueued) onQueue(i);
+            heapSet(i, calcKey(i));
+        }
+        else
+            heapRemove(i);
+    }
+
+    // False if cancelled while clearing the per-cell arrays
+    bool reset(CancelFlag cancel)
+    {
+        const std::size_t n = _grid->size();
+        _valid = false;
+        if (!assignCancellable(_g, n, cInf, cancel) || !assignCancellable(_rhs, n, cInf, cancel) ||
+            !assignCancellable(_pos, n, cNotQueued, cancel))
+            return false;
+        _heap.clear();
+        _km = 0;
+        _last = _start;
+        const std::size_t gi = _grid->index(_goal);
+        _rhs[gi] = 0;
+        heapSet(gi, calcKey(gi));
+        _version = _grid->version();
+        _generation = _grid->generation();
+        _valid = true;
+        return true;
+    }
+
+public:
+    void attach(const Grid& grid)
+    {
+        _grid = &grid;
+        _valid = false;
+    }
+
+    // Frees the per-cell arrays
+    void release()
+    {
+        std::vector<std::uint32_t>().swap(_g);
+        std::vector<std::uint32_t>().swap(_rhs);
+        std::vector<std::uint32_t>().swap(_pos);
+        std::vector<Entry>().swap(_heap);
+        _valid = false;
+    }
+
+    // The grid's wall at cell was toggled since the last search. Keeps the
+    // values if the grid changed by exactly this edit, otherwise the next
+    // begin() starts over.
+    void wallChanged(Cell cell)
+    {
+        if (!_valid) return;
+        if (_grid->version() != _version + 1 || !_grid->inside(cell))
+        {
+            _valid = false;
+            return;
+        }
+        _version = _grid->version();
+        _generation = _grid->generation();
+
+        // every edge whose cost changed has an end in the 3x3 block around cell
+        // (a diagonal blocked by a corner rule is one between two of its cells)
+        const std::size_t gi = _grid->index(_goal);
+        for (int dr = -1; dr <= 1; dr++)
+        {
+            for (int dc = -1; dc <= 1; dc++)
+            {
+                const int r = cell.r + dr, c = cell.c + dc;
+                if (!_grid->inside(r, c)) continue;
+                const std::size_t i = _grid->index(r, c);
+                if (i != gi)
+                    _rhs[i] = minSucc(i);
+                updateVertex(i, [](std::size_t) {});
+            }
+        }
+    }
+
+    // Prepares a search. Entries left in the queue by the previous search and
+    // by edits stay there; they are not reported, as after a long search that
+    // is its whole frontier. False if cancelled while starting over; the
+    // next begin() starts over again.
+    bool begin(Cell start, Cell goal, bool diagonal, CornerRule corners, CancelFlag cancel = nullptr)
+    {
+        const bool keep = _valid && goal == _goal && diagonal == _diagonal && corners == _corners &&
+                          _generation == _grid->generation() && _g.size() == _grid->size();
+        _start = start;
+        _goal = goal;
+        _diagonal = diagonal;
+        _corners = corners;
+        if (!keep)
+            return reset(cancel);
+        if (start != _last)
+        {
+            // keys already queued were computed for the old start; km keeps them valid lower bounds
+            _km += distance(start.r, start.c, _last);
+            _last = start;
+        }
+        return true;
+    }
+
+    // True once g(start) is final
+    bool done() const
+    {
+        const std::size_t si = _grid->index(_start);
+        return _rhs[si] == _g[si] && (_heap.empty() || _heap.front().key >= calcKey(si));
+    }
+
+    // Processes the top vertex. Calls onExpand(i) for a vertex whose g was
+    // settled or raised, onQueue(i) for vertices entering the queue.
+    template <class OnExpand, class OnQueue>
+    void step(OnExpand&& onExpand, OnQueue&& onQueue)
+    {
+        const std::size_t gi = _grid->index(_goal);
+        const std::size_t u = _heap.front().cell;
+        const std::uint64_t kOld = _heap.front().key;
+        const std::uint64_t kNew = calcKey(u);
+        if (kOld < kNew)
+        {
+            heapSet(u, kNew);
+            return;
+        }
+
+        onExpand(u);
+        if (_g[u] > _rhs[u])
+        {
+            // overconsistent: settle and lower the predecessors
+            _g[u] = _rhs[u];
+            heapRemove(u);
+            forNeighbors(u, [&](std::size_t s, std::uint32_t cost)
+            {
+                if (s != gi)
+                    _rhs[s] = std::min(_rhs[s], add(_g[u], cost));
+                updateVertex(s, onQueue);
+            });
+        }
+        else
+        {
+            // underconsistent: raise and recompute everything that relied on u
+            const std::uint32_t gOld = _g[u];
+            _g[u] = cInf;
+            forNeighbors(u, [&](std::size_t s, std::uint32_t cost)
+            {
+                if (s != gi && _rhs[s] == add(gOld, cost))
+                    _rhs[s] = minSucc(s);
+                updateVertex(s, onQueue);
+            });
+            if (u != gi)
+                _rhs[u] = minSucc(u);
+            updateVertex(u, onQueue);
+        }
+    }
+
+    std::size_t queueSize() const { return _heap.size(); }
+    std::size_t memoryBytes() const
+    {
+        return (_g.capacity() + _rhs.capacity() + _pos.capacity()) * sizeof(std::uint32_t) + _heap.capacity() * sizeof(Entry);
+    }
+
+    // Cost from the start to the goal once done(), cInf if unreachable
+    std::uint32_t startCost() const { return _g[_grid->index(_start)]; }
+
+    // Greedy descent on g from the start; call once done() and solvable
+    void path(std::vector<Cell>& out) const
+    {
+        out.clear();
+        std::size_t cur = _grid->index(_start);
+        const std::size_t gi = _grid->index(_goal);
+        out.push_back(_start);
+        for (std::size_t n = 0; cur != gi && n < _grid->size(); n++)
+        {
+            std::size_t best = cur;
+            std::uint32_t bestCost = cInf;
+            forNeighbors(cur, [&](std::size_t s, std::uint32_t cost)
+            {
+                const std::uint32_t v = add(_g[s], cost);
+                if (v < bestCost) { bestCost = v; best = s; }
+            });
+            if (best == cur) break;
+            cur = best;
+            out.push_back(_grid->cellAt(cur));
+        }
+    }
+};
+
+} // namespace maze
@@ -0,0 +1,65 @@
+#pragma once
+#include <random>
+#include <algorithm>
+#include <cstdint>
+
+#include "Grid.h"
+
+namespace maze
+{
+
+struct GenOptions
+{
+    float density = 0.28f;      // wall probability
+    bool guaranteePath = true;
+};
+
+// Fills the grid with random walls and resets start/goal to opposite corners.
+// Returns the seed actually used (a random one when seed == 0).
+inline unsigned generate(Grid& grid, const GenOptions& opt, unsigned seed = 0)
+{
+    if (seed == 0)
+    {
+        std::random_device rd;
+        seed = rd();
+    }
+    std::mt19937 rng(seed);
+
+    // Compare raw 32-bit draws against a fixed threshold: one RNG call and no
+    // float conversion per cell keeps generation linear and cheap on huge grids.
+    const double d = std::max(0.0, std::min(double(opt.density), 1.0));
+    const std::uint64_t threshold = std::uint64_t(d * 4294967296.0);
+
+    const int R = grid.rows(), C = grid.cols();
+    for (int r=0; r<R; r++)
+        for (int c=0; c<C; c++)
+            grid.setWall(r, c, std::uint64_t(rng()) < threshold);
+
+    auto open=[&](int r,int c){
+        if (grid.inside(r,c))
+            grid.setWall(r, c, false);
+    };
+
+    // keep corners open
+    for (int dr=0; dr<=1; dr++)
+        for (int dc=0; dc<=1; dc++)
+        {
+            open(0+dr, 0+dc);
+            open(R-1-dr, C-1-dc);
+        }
+
+    if (opt.guaranteePath)
+    {
+        // Guaranteed corridor: top row then right column (simple and robust)
+        for (int c = 0; c < C; c++)
+            grid.setWall(0, c, false);
+        for (int r = 0; r < R; r++)
+            grid.setWall(r, C - 1, false);
+    }
+
+    grid.setStart({0,0});
+    grid.setGoal({R-1, C-1});
+    return seed;
+}
+
+} // namespace maze
@@ -0,0 +1,128 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+#include "MazeTypes.h"
+#include "BitGrid.h"
+
+namespace maze
+{
+
+// Wall grid plus start/goal; no search or drawing state
+class Grid
+{
+public:
+    // 16384 x 16384 = 268M cells, still addressable with a 32-bit CellIndex
+    static constexpr int cMinDim = 5;
+    static constexpr int cMaxDim = 16384;
+
+    static int clampDim(int n) { return std::max(cMinDim, std::min(n, cMaxDim)); }
+
+private:
+    int _rows = 0;
+    int _cols = 0;
+    BitGrid _walls;
+    std::uint64_t _version = 0;         // bumped on every wall/size change
+    std::uint64_t _generation = 0;      // process-wide id of the current walls
+
+    // Every wall/size change of any grid draws a fresh generation
+    static std::uint64_t nextGeneration()
+    {
+        static std::atomic<std::uint64_t> next{0};
+        return ++next;
+    }
+
+    void changed()
+    {
+        ++_version;
+        _generation = nextGeneration();
+    }
+
+    Cell _start{0,0};
+    Cell _goal{0,0};
+
+public:
+    Grid() = default;
+    Grid(int rows, int cols) { resize(rows, cols); }
+
+    void resize(int rows, int cols)
+    {
+        _rows = rows;
+        _cols = cols;
+        _walls.resize(rows, cols);
+        changed();
+        _start = {0,0};
+        _goal = {_rows-1, _cols-1};
+    }
+
+    // Like resize(), but the walls are words in BitGrid layout owned
+    // elsewhere (a mapped file); see BitGrid::view. False and nothing changed
+    // if their border is not closed.
+    bool viewWalls(int rows, int cols, std::uint64_t* words, std::shared_ptr<void> owner)
+    {
+        if (!_walls.view(rows, cols, words, std::move(owner)))
+            return false;
+        _rows = rows;
+        _cols = cols;
+        changed();
+        _start = {0,0};
+        _goal = {_rows-1, _cols-1};
+        return true;
+    }
+
+    // Like resize(), but takes walls that were filled in elsewhere (an
+    // importer), so a grid only changes once the whole file has been read
+    void assignWalls(BitGrid&& walls)
+    {
+        _walls.swap(walls);
+        _rows = _walls.rows();
+        _cols = _walls.cols();
+        changed();
+        _start = {0,0};
+        _goal = {_rows-1, _cols-1};
+    }
+
+    int rows() const { return _rows; }
+    int cols() const { return _cols; }
+    std::size_t size() const { return std::size_t(_rows) * std::size_t(_cols); }
+
+    std::size_t index(int r, int c) const { return std::size_t(r)*std::size_t(_cols) + std::size_t(c); }
+    std::size_t index(Cell cell) const { return index(cell.r, cell.c); }
+    Cell cellAt(std::size_t i) const { return {int(i / std::size_t(_cols)), int(i % std::size_t(_cols))}; }
+
+    bool inside(int r, int c) const { return r>=0 && r<_rows && c>=0 && c<_cols; }
+    bool inside(Cell cell) const { return inside(cell.r, cell.c); }
+
+    // Out-of-range cells one step outside the grid read as walls
+    bool isWall(int r, int c) const { return _walls.get(r, c); }
+    bool isWall(Cell cell) const { return isWall(cell.r, cell.c); }
+    bool isWall(std::size_t i) const { return isWall(cellAt(i)); }
+
+    void setWall(int r, int c, bool wall) { _walls.set(r, c, wall); changed(); }
+    void toggleWall(int r, int c) { setWall(r, c, !isWall(r,c)); }
+    void clearWalls() { _walls.clear(); changed(); }
+
+    // Changes whenever walls or size change; lets derived data detect staleness
+    std::uint64_t version() const { return _version; }
+
+    // Unlike version(), never repeats across grids or over time (a copy
+    // shares it until either side changes), so it identifies the walls on
+    // its own, without the grid's address
+    std::uint64_t generation() const { return _generation; }
+
+    const BitGrid& walls() const { return _walls; }
+
+    // See BitGrid::walls3x3
+    unsigned walls3x3(int r, int c) const { return _walls.walls3x3(r, c); }
+
+    const Cell& start() const { return _start; }
+    const Cell& goal() const { return _goal; }
+    void setStart(Cell cell) { _start = cell; }
+    void setGoal(Cell cell) { _goal = cell; }
+};
+
+} // namespace maze
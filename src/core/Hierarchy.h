@@ -0,0 +1,984 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <functional>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+
+#include "Grid.h"
+#include "MazeTypes.h"
+
+namespace maze
+{
+
+// Rows [r0, r1) and columns [c0, c1) of the grid
+struct CellRect
+{
+    int r0 = 0, c0 = 0, r1 = 0, c1 = 0;
+
+    bool contains(int r, int c) const { return r >= r0 && r < r1 && c >= c0 && c < c1; }
+    int width() const { return c1 - c0; }
+    std::size_t area() const { return std::size_t(r1 - r0) * std::size_t(c1 - c0); }
+};
+
+// Priority queue entry: f, ties broken towards larger g (as in OpenNode)
+struct HierarchyEntry
+{
+    std::uint64_t key;          // (f << 32) | ~g
+    std::uint32_t id;
+
+    HierarchyEntry(std::uint32_t f, std::uint32_t g, std::uint32_t i)
+    : key((std::uint64_t(f) << 32) | std::uint64_t(~g)), id(i) {}
+    bool operator>(const HierarchyEntry& o) const { return key > o.key; }
+};
+
+// Shortest paths that stay inside one rectangle of the grid (a cluster).
+// The rectangle's walls are copied into a mask with a wall frame around it,
+// so moves are index offsets without bounds checks; the mask is kept while
+// the rectangle and the grid stay the same (the n sweeps of one cluster).
+// Scratch is sized for the largest rectangle seen and generation-stamped, so
+// a run costs in proportion to the cells it reaches. Sweeps use a bucket
+// queue (Dial): move costs are small, so a ring of cDiagCost + 1 buckets
+// holds every pending cost.
+class LocalSearch
+{
+public:
+    static constexpr std::uint32_t cInf = 0xFFFFFFFFu;
+
+private:
+    const Grid* _grid = nullptr;
+    bool _diagonal = false;
+    CornerRule _corners = CornerRule::Cut;
+    CellRect _rect;
+    Cell _src;
+
+    // rect plus a one-cell frame, row-major with stride _pw
+    std::vector<std::uint8_t> _blocked;
+    std::size_t _pw = 0;
+    std::ptrdiff_t _off[8] = {};
+    std::uint64_t _maskGeneration = 0;      // Grid::generation() of the loaded mask, 0 if none
+    CellRect _maskRect;
+
+    std::vector<std::uint32_t> _g;
+    std::vector<std::uint32_t> _seen;       // stamp: g and dir are valid
+    std::vector<std::uint32_t> _closed;     // stamp: g is final
+    std::vector<std::uint32_t> _wanted;     // stamp: sweep may stop once these are final
+    std::vector<std::int8_t> _dir;          // move that reached the cell
+    std::uint32_t _stamp = 0;
+    std::vector<HierarchyEntry> _heap;      // A*: min-heap
+    std::vector<std::uint32_t> _ring[cDiagCost + 1];   // sweeps: bucket g % size
+    std::uint64_t _expansions = 0;
+
+    std::size_t local(int r, int c) const { return std::size_t(r - _rect.r0 + 1) * _pw + std::size_t(c - _rect.c0 + 1); }
+    int rowOf(std::size_t i) const { return _rect.r0 + int(i / _pw) - 1; }
+    int colOf(std::size_t i) const { return _rect.c0 + int(i % _pw) - 1; }
+
+    std::uint32_t estimate(int r, int c, const Cell& to) const
+    {
+        const int dr = std::abs(r - to.r), dc = std::abs(c - to.c);
+        return _diagonal ? octileCost(dr, dc) : manhattanCost(dr, dc);
+    }
+
+    void loadMask(const CellRect& rect)
+    {
+        const bool same = _maskGeneration == _grid->generation() && _maskRect.r0 == rect.r0 &&
+                          _maskRect.c0 == rect.c0 && _maskRect.r1 == rect.r1 && _maskRect.c1 == rect.c1;
+        _rect = rect;
+        if (same) return;
+        _maskGeneration = _grid->generation();
+        _maskRect = rect;
+
+        const int h = rect.r1 - rect.r0, w = rect.width();
+        _pw = std::size_t(w) + 2;
+        const std::size_t n = _pw * std::size_t(h + 2);
+        _blocked.assign(n, 1);
+        for (int r = rect.r0; r < rect.r1; r++)
+            for (int c = rect.c0; c < rect.c1; c++)
+                _blocked[local(r, c)] = _grid->isWall(r, c) ? 1 : 0;
+        for (int dir = 0; dir < 8; dir++)
+            _off[dir] = std::ptrdiff_t(cDirR[dir]) * std::ptrdiff_t(_pw) + cDirC[dir];
+
+        if (_g.size() < n)
+        {
+            _g.resize(n);
+            _seen.assign(n, 0);
+            _closed.assign(n, 0);
+            _wanted.assign(n, 0);
+            _dir.resize(n);
+            _stamp = 0;
+        }
+    }
+
+    void push(std::uint32_t f, std::uint32_t g, std::size_t i)
+    {
+        _heap.emplace_back(f, g, std::uint32_t(i));
+        std::push_heap(_heap.begin(), _heap.end(), std::greater<HierarchyEntry>());
+    }
+
+    // Relaxes the moves out of cell i; fn(ni, g) for each improvement
+    template <bool Diagonal, CornerRule Rule, class Fn>
+    void relaxFrom(std::size_t i, Fn&& fn)
+    {
+        const std::uint32_t g = _g[i];
+        for (int dir = 0; dir < (Diagonal ? 8 : 4); dir++)
+        {
+            const std::size_t ni = std::size_t(std::ptrdiff_t(i) + _off[dir]);
+            if (_blocked[ni]) continue;
+            if (Diagonal && Rule != CornerRule::Cut && cDirR[dir] != 0 && cDirC[dir] != 0)
+            {
+                // both side cells lie inside the rect
+                const bool a = _blocked[std::size_t(std::ptrdiff_t(i) + _off[dir] - cDirC[dir])] != 0;
+                const bool b = _blocked[i + std::size_t(std::ptrdiff_t(cDirC[dir]))] != 0;
+                if (Rule == CornerRule::NoCut ? (a || b) : (a && b)) continue;
+            }
+            const std::uint32_t ng = g + stepCost(dir);
+            if (_seen[ni] == _stamp && ng >= _g[ni]) continue;
+            _seen[ni] = _stamp;
+            _g[ni] = ng;
+            _dir[ni] = std::int8_t(dir);
+            fn(ni, ng);
+        }
+    }
+
+    template <bool Diagonal, CornerRule Rule>
+    void sweep(std::size_t wanted)
+    {
+        constexpr std::uint32_t cRing = cDiagCost + 1;
+        std::size_t pending = 1;
+        for (auto& bucket : _ring)
+            bucket.clear();
+        _ring[0].push_back(std::uint32_t(local(_src.r, _src.c)));
+        for (std::uint32_t g = 0; pending > 0; g++)
+        {
+            std::vector<std::uint32_t>& bucket = _ring[g % cRing];
+            // every move costs more than 0, so nothing lands in the bucket being drained
+            for (std::size_t k = 0; k < bucket.size(); k++)
+            {
+                const std::size_t i = bucket[k];
+                pending--;
+                if (_closed[i] == _stamp || _g[i] != g) continue;
+                _closed[i] = _stamp;
+                ++_expansions;
+                if (_wanted[i] == _stamp && --wanted == 0) return;
+                relaxFrom<Diagonal, Rule>(i, [&](std::size_t ni, std::uint32_t ng)
+                {
+                    _ring[ng % cRing].push_back(std::uint32_t(ni));
+                    pending++;
+                });
+            }
+            bucket.clear();
+        }
+    }
+
+    template <bool Diagonal, CornerRule Rule>
+    std::uint32_t astar(const Cell& target)
+    {
+        _heap.clear();
+        push(estimate(_src.r, _src.c, target), 0, local(_src.r, _src.c));
+        const std::size_t ti = local(target.r, target.c);
+        while (!_heap.empty())
+        {
+            std::pop_heap(_heap.begin(), _heap.end(), std::greater<HierarchyEntry>());
+            const std::size_t i = _heap.back().id;
+            _heap.pop_back();
+            if (_closed[i] == _stamp) continue;
+            _closed[i] = _stamp;
+            ++_expansions;
+            if (i == ti) return _g[i];
+            relaxFrom<Diagonal, Rule>(i, [&](std::size_t ni, std::uint32_t ng)
+            {
+                push(ng + estimate(rowOf(ni), colOf(ni), target), ng, ni);
+            });
+        }
+        return cInf;
+    }
+
+    template <bool Diagonal, CornerRule Rule>
+    std::uint32_t search(const Cell* target, std::size_t wanted)
+    {
+        if (target) return astar<Diagonal, Rule>(*target);
+        sweep<Diagonal, Rule>(wanted);
+        return 0;
+    }
+
+public:
+    void setup(const Grid& grid, bool diagonal, CornerRule corners)
+    {
+        _grid = &grid;
+        _diagonal = diagonal;
+        _corners = corners;
+        _maskGeneration = 0;
+    }
+
+    // Dijkstra from src over rect (target == nullptr) until every cell in
+    // wanted[0, nWanted) is settled, or over all of rect if nWanted is 0; or
+    // A* until *target is settled. Returns the cost to *target (cInf if it
+    // cannot be reached inside rect), 0 for a sweep.
+    std::uint32_t run(const CellRect& rect, Cell src, const Cell* target, const Cell* wanted = nullptr,
+                      std::size_t nWanted = 0)
+    {
+        loadMask(rect);
+        _src = src;
+        if (++_stamp == 0)
+        {
+            std::fill(_seen.begin(), _seen.end(), 0);
+            std::fill(_closed.begin(), _closed.end(), 0);
+            std::fill(_wanted.begin(), _wanted.end(), 0);
+            _stamp = 1;
+        }
+
+        const std::size_t si = local(src.r, src.c);
+        _g[si] = 0;
+        _dir[si] = -1;
+        _seen[si] = _stamp;
+
+        std::size_t count = 0;
+        for (std::size_t k = 0; k < nWanted; k++)
+        {
+            const std::size_t i = local(wanted[k].r, wanted[k].c);
+            if (_wanted[i] != _stamp) count++;
+            _wanted[i] = _stamp;
+        }
+        if (count == 0) count = _blocked.size();
+
+        if (!_diagonal) return search<false, CornerRule::Cut>(target, count);
+        switch (_corners)
+        {
+            case CornerRule::NoCut:     return search<true, CornerRule::NoCut>(target, count);
+            case CornerRule::NoSqueeze: return search<true, CornerRule::NoSqueeze>(target, count);
+            case CornerRule::Cut:
+            default:                    return search<true, CornerRule::Cut>(target, count);
+        }
+    }
+
+    // Cost from the last run's source to cell (inside its rect); cInf if not reached
+    std::uint32_t dist(Cell cell) const
+    {
+        const std::size_t i = local(cell.r, cell.c);
+        return _closed[i] == _stamp ? _g[i] : cInf;
+    }
+
+    // Appends the cells after the source up to target, which the last run reached
+    void appendPath(Cell target, std::vector<Cell>& out) const
+    {
+        const std::size_t first = out.size();
+        Cell t = target;
+        while (t != _src)
+        {
+            out.push_back(t);
+            const int dir = _dir[local(t.r, t.c)];
+            t.r -= cDirR[dir];
+            t.c -= cDirC[dir];
+        }
+        std::reverse(out.begin() + std::ptrdiff_t(first), out.end());
+    }
+
+    std::uint64_t expansions() const { return _expansions; }
+    void resetExpansions() { _expansions = 0; }
+
+    std::size_t bytes() const
+    {
+        std::size_t n = (_g.capacity() + _seen.capacity() + _closed.capacity() + _wanted.capacity()) * sizeof(std::uint32_t) +
+                        _dir.capacity() + _blocked.capacity() + _heap.capacity() * sizeof(HierarchyEntry);
+        for (const auto& bucket : _ring)
+            n += bucket.capacity() * sizeof(std::uint32_t);
+        return n;
+    }
+};
+
+// HPA* abstract graph (Botea, Müller & Schaeffer). The grid is cut into
+// square clusters. Where two neighbouring clusters touch, every maximal run
+// of free cell pairs across the border is an entrance with one transition (a
+// pair of nodes, one per side) in its middle, or two at its ends if it is
+// long. With corner cutting, a diagonal crossing whose two side cells are
+// walls gets a transition of its own, also at cluster corners; under the
+// other corner rules every diagonal crossing has an orthogonal detour
+// through one of the runs. Inside a cluster, the nodes are joined by their
+// shortest distance within the cluster.
+//
+// Every free cell path between clusters passes through some entrance, so the
+// graph keeps connectivity; paths through it are optimal up to the detours
+// to the transitions (typically a few percent longer).
+//
+// wallChanged() recomputes only the borders next to the cell and the
+// clusters touching them (at most four). The graph is read-only during
+// queries, so several HierarchySearch instances (threads) can share one.
+class PathHierarchy
+{
+public:
+    static constexpr std::uint32_t cInf = LocalSearch::cInf;
+    static constexpr int cDefaultClusterSize = 16;
+    static constexpr int cMinClusterSize = 4;
+    static constexpr int cMaxClusterSize = 256;
+
+    // Edge from a node to a node of another cluster
+    struct Link
+    {
+        std::uint32_t cluster;      // cluster across the border
+        std::uint32_t node;         // local node index there
+        std::uint32_t cost;
+    };
+
+    struct Cluster
+    {
+        std::vector<CellIndex> nodes;       // transition cells, sorted
+        std::vector<std::uint32_t> dist;    // nodes x nodes, cInf if not connected inside the cluster
+        std::vector<Link> links;            // grouped by node: [firstLink[i], firstLink[i + 1])
+        std::vector<std::uint32_t> firstLink;
+    };
+
+private:
+    // Runs at least this long get a transition at each end
+    static constexpr int cLongEntrance = 6;
+
+    // One move across a border: a in the cluster above / left, b in the other
+    struct Crossing
+    {
+        CellIndex a, b;
+        std::uint32_t cost;
+    };
+    using Crossings = std::vector<Crossing>;
+
+    const Grid* _grid = nullptr;
+    bool _diagonal = false;
+    CornerRule _corners = CornerRule::Cut;
+    int _k = cDefaultClusterSize;
+    bool _valid = false;
+    std::uint64_t _version = 0;             // edit count, for wallChanged()
+    std::uint64_t _generation = 0;          // Grid::generation() it describes
+
+    int _cy = 0, _cx = 0;                   // clusters per column, per row
+    std::vector<Cluster> _clusters;
+    std::vector<std::uint32_t> _base;       // first node id of each cluster; _base[n] = node count
+    std::vector<std::uint32_t> _owner;      // cluster of each node id
+    std::vector<Crossings> _vBorder;        // between (y,x) and (y,x+1): [y*(_cx-1) + x]
+    std::vector<Crossings> _hBorder;        // between (y,x) and (y+1,x): [y*_cx + x]
+    std::vector<Crossings> _corner;         // diagonals where (y,x), (y,x+1), (y+1,x), (y+1,x+1) meet: [y*(_cx-1) + x]
+    LocalSearch _local;
+
+    bool free(int r, int c) const { return !_grid->isWall(r, c); }
+    CellIndex at(int r, int c) const { return CellIndex(_grid->index(r, c)); }
+    bool cutsCorners() const { return _diagonal && _corners == CornerRule::Cut; }
+
+    // Transitions for one entrance run of (rows or columns) [from, to)
+    template <class Emit>
+    static void emitRun(int from, int to, Emit&& emit)
+    {
+        if (to - from >= cLongEntrance)
+        {
+            emit(from);
+            emit(to - 1);
+        }
+        else
+            emit(from + (to - from) / 2);
+    }
+
+    // Border between cluster (y,x) and (y,x+1): columns ca | ca+1
+    void computeVBorder(int y, int x)
+    {
+        Crossings& out = _vBorder[std::size_t(y) * std::size_t(_cx - 1) + std::size_t(x)];
+        out.clear();
+        const int ca = (x + 1) * _k - 1, cb = ca + 1;
+        const int r0 = y * _k, r1 = std::min(_grid->rows(), r0 + _k);
+        auto emit = [&](int r) { out.push_back({at(r, ca), at(r, cb), cOrthCost}); };
+        int run = -1;
+        for (int r = r0; r <= r1; r++)
+        {
+            const bool open = r < r1 && free(r, ca) && free(r, cb);
+            if (open && run < 0) run = r;
+            if (!open && run >= 0)
+            {
+                emitRun(run, r, emit);
+                run = -1;
+            }
+        }
+        if (!cutsCorners()) return;
+        for (int r = r0; r + 1 < r1; r++)
+        {
+            if (free(r, ca) && free(r + 1, cb) && !free(r, cb) && !free(r + 1, ca))
+                out.push_back({at(r, ca), at(r + 1, cb), cDiagCost});
+            if (free(r + 1, ca) && free(r, cb) && !free(r, ca) && !free(r + 1, cb))
+                out.push_back({at(r + 1, ca), at(r, cb), cDiagCost});
+        }
+    }
+
+    // Border between cluster (y,x) and (y+1,x): rows ra / ra+1
+    void computeHBorder(int y, int x)
+    {
+        Crossings& out = _hBorder[std::size_t(y) * std::size_t(_cx) + std::size_t(x)];
+        out.clear();
+        const int ra = (y + 1) * _k - 1, rb = ra + 1;
+        const int c0 = x * _k, c1 = std::min(_grid->cols(), c0 + _k);
+        auto emit = [&](int c) { out.push_back({at(ra, c), at(rb, c), cOrthCost}); };
+        int run = -1;
+        for (int c = c0; c <= c1; c++)
+        {
+            const bool open = c < c1 && free(ra, c) && free(rb, c);
+            if (open && run < 0) run = c;
+            if (!open && run >= 0)
+            {
+                emitRun(run, c, emit);
+                run = -1;
+            }
+        }
+        if (!cutsCorners()) return;
+        for (int c = c0; c + 1 < c1; c++)
+        {
+            if (free(ra, c) && free(rb, c + 1) && !free(ra, c + 1) && !free(rb, c))
+                out.push_back({at(ra, c), at(rb, c + 1), cDiagCost});
+            if (free(ra, c + 1) && free(rb, c) && !free(ra, c) && !free(rb, c + 1))
+                out.push_back({at(ra, c + 1), at(rb, c), cDiagCost});
+        }
+    }
+
+    // Diagonals through the point where four clusters meet
+    void computeCorner(int y, int x)
+    {
+        Crossings& out = _corner[std::size_t(y) * std::size_t(_cx - 1) + std::size_t(x)];
+        out.clear();
+        if (!cutsCorners()) return;
+        const int ra = (y + 1) * _k - 1, ca = (x + 1) * _k - 1;
+        if (free(ra, ca) && free(ra + 1, ca + 1) && !free(ra, ca + 1) && !free(ra + 1, ca))
+            out.push_back({at(ra, ca), at(ra + 1, ca + 1), cDiagCost});
+        if (free(ra, ca + 1) && free(ra + 1, ca) && !free(ra, ca) && !free(ra + 1, ca + 1))
+            out.push_back({at(ra, ca + 1), at(ra + 1, ca), cDiagCost});
+    }
+
+    // Calls fn(crossings) for every border and corner list of cluster (y,x)
+    template <class Fn>
+    void forBorders(int y, int x, Fn&& fn) const
+    {
+        const std::size_t vw = std::size_t(_cx - 1);
+        if (x > 0) fn(_vBorder[std::size_t(y) * vw + std::size_t(x - 1)]);
+        if (x + 1 < _cx) fn(_vBorder[std::size_t(y) * vw + std::size_t(x)]);
+        if (y > 0) fn(_hBorder[std::size_t(y - 1) * std::size_t(_cx) + std::size_t(x)]);
+        if (y + 1 < _cy) fn(_hBorder[std::size_t(y) * std::size_t(_cx) + std::size_t(x)]);
+        for (int dy = -1; dy <= 0; dy++)
+            for (int dx = -1; dx <= 0; dx++)
+                if (y + dy >= 0 && y + dy + 1 < _cy && x + dx >= 0 && x + dx + 1 < _cx)
+                    fn(_corner[std::size_t(y + dy) * vw + std::size_t(x + dx)]);
+    }
+
+    // Collects the cluster's nodes from its borders and measures the
+    // distances between them
+    void buildCluster(int y, int x)
+    {
+        const int id = y * _cx + x;
+        Cluster& cl = _clusters[std::size_t(id)];
+        cl.nodes.clear();
+        forBorders(y, x, [&](const Crossings& list)
+        {
+            for (const Crossing& k : list)
+            {
+                if (clusterOf(k.a) == id) cl.nodes.push_back(k.a);
+                if (clusterOf(k.b) == id) cl.nodes.push_back(k.b);
+            }
+        });
+        std::sort(cl.nodes.begin(), cl.nodes.end());
+        cl.nodes.erase(std::unique(cl.nodes.begin(), cl.nodes.end()), cl.nodes.end());
+
+        const std::size_t n = cl.nodes.size();
+        cl.dist.assign(n * n, cInf);
+        std::vector<Cell> cells(n);
+        for (std::size_t i = 0; i < n; i++)
+            cells[i] = _grid->cellAt(cl.nodes[i]);
+        const CellRect rect = clusterRect(id);
+        for (std::size_t i = 0; i < n; i++)
+        {
+            cl.dist[i * n + i] = 0;
+            if (i + 1 == n) break;
+            // only the later nodes are still needed
+            _local.run(rect, cells[i], nullptr, cells.data() + i + 1, n - i - 1);
+            for (std::size_t j = i + 1; j < n; j++)
+                cl.dist[i * n + j] = cl.dist[j * n + i] = _local.dist(cells[j]);
+        }
+    }
+
+    // Resolves the cluster's border crossings to (cluster, local node)
+    // links; needed again whenever a neighbour's nodes change
+    void linkCluster(int y, int x)
+    {
+        const int id = y * _cx + x;
+        Cluster& cl = _clusters[std::size_t(id)];
+        std::vector<std::pair<std::uint32_t, Link>> links;
+        forBorders(y, x, [&](const Crossings& list)
+        {
+            for (const Crossing& k : list)
+            {
+                const int ca = clusterOf(k.a), cb = clusterOf(k.b);
+                if (ca == id)
+                    links.push_back({std::uint32_t(localIndex(id, k.a)), {std::uint32_t(cb), std::uint32_t(localIndex(cb, k.b)), k.cost}});
+                if (cb == id)
+                    links.push_back({std::uint32_t(localIndex(id, k.b)), {std::uint32_t(ca), std::uint32_t(localIndex(ca, k.a)), k.cost}});
+            }
+        });
+        std::stable_sort(links.begin(), links.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        cl.links.clear();
+        cl.firstLink.assign(cl.nodes.size() + 1, 0);
+        for (const auto& l : links)
+        {
+            cl.links.push_back(l.second);
+            cl.firstLink[l.first + 1]++;
+        }
+        for (std::size_t i = 0; i < cl.nodes.size(); i++)
+            cl.firstLink[i + 1] += cl.firstLink[i];
+    }
+
+    void updateBase()
+    {
+        _base.resize(_clusters.size() + 1);
+        std::uint32_t sum = 0;
+        for (std::size_t k = 0; k < _clusters.size(); k++)
+        {
+            _base[k] = sum;
+            sum += std::uint32_t(_clusters[k].nodes.size());
+        }
+        _base[_clusters.size()] = sum;
+        _owner.resize(sum);
+        for (std::size_t k = 0; k < _clusters.size(); k++)
+            std::fill(_owner.begin() + _base[k], _owner.begin() + _base[k + 1], std::uint32_t(k));
+    }
+
+public:
+    // Cuts the grid into clusters of clusterSize x clusterSize cells and
+    // builds the graph for the movement model. A cancelled build leaves the
+    // graph invalid.
+    void build(const Grid& grid, bool diagonal, CornerRule corners, int clusterSize = cDefaultClusterSize,
+               CancelFlag cancel = nullptr)
+    {
+        _grid = &grid;
+        _diagonal = diagonal;
+        _corners = corners;
+        _k = std::max(cMinClusterSize, std::min(clusterSize, cMaxClusterSize));
+        _version = grid.version();
+        _generation = grid.generation();
+        _valid = true;
+        _local.setup(grid, diagonal, corners);
+
+        _cy = (grid.rows() + _k - 1) / _k;
+        _cx = (grid.cols() + _k - 1) / _k;
+        _clusters.assign(std::size_t(_cy) * std::size_t(_cx), Cluster());
+        _vBorder.assign(std::size_t(_cy) * std::size_t(_cx - 1), Crossings());
+        _hBorder.assign(std::size_t(_cy - 1) * std::size_t(_cx), Crossings());
+        _corner.assign(std::size_t(_cy - 1) * std::size_t(_cx - 1), Crossings());
+
+        // checked once per row of clusters
+        auto stop = [&]
+        {
+            if (!cancelled(cancel)) return false;
+            _valid = false;
+            return true;
+        };
+        for (int y = 0; y < _cy; y++)
+        {
+            if (stop()) return;
+            for (int x = 0; x < _cx; x++)
+            {
+                if (x + 1 < _cx) computeVBorder(y, x);
+                if (y + 1 < _cy) computeHBorder(y, x);
+                if (x + 1 < _cx && y + 1 < _cy) computeCorner(y, x);
+            }
+        }
+        for (int y = 0; y < _cy; y++)
+        {
+            if (stop()) return;
+            for (int x = 0; x < _cx; x++)
+                buildCluster(y, x);
+        }
+        for (int y = 0; y < _cy; y++)
+            for (int x = 0; x < _cx; x++)
+                linkCluster(y, x);
+        updateBase();
+    }
+
+    // True if the graph describes this grid as it is now, for this movement model
+    bool matches(const Grid& grid, bool diagonal, CornerRule corners, int clusterSize) const
+    {
+        return _valid && _grid == &grid && _generation == grid.generation() && _diagonal == diagonal &&
+               _corners == corners && _k == std::max(cMinClusterSize, std::min(clusterSize, cMaxClusterSize)) &&
+               std::size_t(_cy) * std::size_t(_cx) == _clusters.size() && _cy == (grid.rows() + _k - 1) / _k &&
+               _cx == (grid.cols() + _k - 1) / _k;
+    }
+
+    // The wall at cell was toggled; call right after each edit. Any other grid
+    // change in between makes the graph stale until the next build().
+    void wallChanged(Cell cell)
+    {
+        if (!_valid) return;
+        if (_grid->version() != _version + 1 || !_grid->inside(cell))
+        {
+            _valid = false;
+            return;
+        }
+        _version = _grid->version();
+        _generation = _grid->generation();
+
+        const int y = cell.r / _k, x = cell.c / _k;
+        const int ry = cell.r % _k, rx = cell.c % _k;
+        int rebuild[4][2];
+        int nRebuild = 0;
+        auto touch = [&](int cy, int cx)
+        {
+            for (int k = 0; k < nRebuild; k++)
+                if (rebuild[k][0] == cy && rebuild[k][1] == cx) return;
+            rebuild[nRebuild][0] = cy;
+            rebuild[nRebuild][1] = cx;
+            nRebuild++;
+        };
+        touch(y, x);
+
+        // borders that read the cell: it lies in one of their two columns / rows
+        if (rx == 0 && x > 0) { computeVBorder(y, x - 1); touch(y, x - 1); }
+        if (rx == _k - 1 && x + 1 < _cx) { computeVBorder(y, x); touch(y, x + 1); }
+        if (ry == 0 && y > 0) { computeHBorder(y - 1, x); touch(y - 1, x); }
+        if (ry == _k - 1 && y + 1 < _cy) { computeHBorder(y, x); touch(y + 1, x); }
+
+        // corners whose 2x2 block holds the cell
+        const int py = (ry == 0) ? y - 1 : (ry == _k - 1) ? y : -1;
+        const int px = (rx == 0) ? x - 1 : (rx == _k - 1) ? x : -1;
+        if (py >= 0 && px >= 0 && py + 1 < _cy && px + 1 < _cx)
+        {
+            computeCorner(py, px);
+            touch(py, px);
+            touch(py, px + 1);
+            touch(py + 1, px);
+            touch(py + 1, px + 1);
+        }
+
+        for (int k = 0; k < nRebuild; k++)
+            buildCluster(rebuild[k][0], rebuild[k][1]);
+        // links into a rebuilt cluster hold its old node indices
+        for (int cy = std::max(0, y - 2); cy <= std::min(_cy - 1, y + 2); cy++)
+            for (int cx = std::max(0, x - 2); cx <= std::min(_cx - 1, x + 2); cx++)
+                linkCluster(cy, cx);
+        updateBase();
+    }
+
+    // Drops all memory; matches() is false until the next build()
+    void release()
+    {
+        *this = PathHierarchy();
+    }
+
+    const Grid& grid() const { return *_grid; }
+    bool diagonal() const { return _diagonal; }
+    CornerRule corners() const { return _corners; }
+    int clusterSize() const { return _k; }
+    std::size_t clusterCount() const { return _clusters.size(); }
+    std::uint32_t nodeCount() const { return _base.empty() ? 0 : _base.back(); }
+
+    int clusterOf(int r, int c) const { return (r / _k) * _cx + (c / _k); }
+    int clusterOf(CellIndex i) const
+    {
+        const Cell cell = _grid->cellAt(i);
+        return clusterOf(cell.r, cell.c);
+    }
+
+    CellRect clusterRect(int id) const
+    {
+        const int y = id / _cx, x = id % _cx;
+        return {y * _k, x * _k, std::min(_grid->rows(), (y + 1) * _k), std::min(_grid->cols(), (x + 1) * _k)};
+    }
+
+    const Cluster& cluster(int id) const { return _clusters[std::size_t(id)]; }
+
+    // Local index of the node at cell in cluster id, -1 if the cell is not a node
+    int localIndex(int id, CellIndex cell) const
+    {
+        const std::vector<CellIndex>& nodes = _clusters[std::size_t(id)].nodes;
+        auto it = std::lower_bound(nodes.begin(), nodes.end(), cell);
+        return (it != nodes.end() && *it == cell) ? int(it - nodes.begin()) : -1;
+    }
+
+    // Node ids are dense over all clusters: [base(id), base(id) + nodes)
+    std::uint32_t base(int id) const { return _base[std::size_t(id)]; }
+
+    // Cluster that holds node id
+    int clusterOfNode(std::uint32_t node) const { return int(_owner[node]); }
+
+    std::size_t edgeCount() const
+    {
+        std::size_t n = 0;
+        for (const Cluster& cl : _clusters)
+            n += cl.dist.size() + cl.links.size();
+        return n;
+    }
+
+    std::size_t bytes() const
+    {
+        std::size_t n = _clusters.capacity() * sizeof(Cluster) + (_base.capacity() + _owner.capacity()) * sizeof(std::uint32_t) +
+                        _local.bytes();
+        for (const Cluster& cl : _clusters)
+            n += cl.nodes.capacity() * sizeof(CellIndex) + (cl.dist.capacity() + cl.firstLink.capacity()) * sizeof(std::uint32_t) +
+                 cl.links.capacity() * sizeof(Link);
+        for (const std::vector<Crossings>* borders : {&_vBorder, &_hBorder, &_corner})
+        {
+            n += borders->capacity() * sizeof(Crossings);
+            for (const Crossings& b : *borders)
+                n += b.capacity() * sizeof(Crossing);
+        }
+        return n;
+    }
+};
+
+// One HPA* query over a shared PathHierarchy: the start and goal are joined
+// to the nodes of their clusters (and to each other, if the two clusters
+// touch), A* runs over the abstract graph (step() is one expansion), and the
+// result is refined one segment at a time: a
+// segment inside a cluster is a local A* bounded by the cluster, a segment
+// across a border is one move. Callers that only need the next stretch of
+// a long path refine just that segment.
+class HierarchySearch
+{
+public:
+    static constexpr std::uint32_t cInf = PathHierarchy::cInf;
+
+private:
+    const PathHierarchy* _h = nullptr;
+    LocalSearch _local;
+
+    Cell _start, _goal;
+    int _startCluster = 0, _goalCluster = 0;
+    std::uint32_t _S = 0, _G = 0;           // virtual node ids of start and goal
+
+    // start / goal joined to the nodes of their clusters: (local index, cost)
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> _startLinks;
+    std::vector<std::uint32_t> _goalDist;   // per node of the goal cluster
+    std::uint32_t _direct = cInf;           // start to goal inside _directRect
+    CellRect _directRect;                   // start and goal clusters, if they touch
+
+    std::vector<std::uint32_t> _g;
+    std::vector<std::uint32_t> _parent;
+    std::vector<std::uint32_t> _seen;
+    std::vector<std::uint32_t> _closed;
+    std::uint32_t _stamp = 0;
+    std::vector<HierarchyEntry> _heap;
+
+    bool _done = false;
+    bool _found = false;
+    std::vector<std::uint32_t> _route;      // abstract path, node ids from _S to _G
+
+    Cell nodeCell(std::uint32_t node) const
+    {
+        if (node == _S) return _start;
+        if (node == _G) return _goal;
+        const int id = _h->clusterOfNode(node);
+        return _h->grid().cellAt(_h->cluster(id).nodes[node - _h->base(id)]);
+    }
+
+    std::uint32_t estimate(const Cell& a) const
+    {
+        const int dr = std::abs(a.r - _goal.r), dc = std::abs(a.c - _goal.c);
+        return _h->diagonal() ? octileCost(dr, dc) : manhattanCost(dr, dc);
+    }
+
+    // Calls fn(neighbor, cost) for every edge of node u
+    template <class Fn>
+    void forEdges(std::uint32_t u, Fn&& fn) const
+    {
+        if (u == _S)
+        {
+            const std::uint32_t base = _h->base(_startCluster);
+            for (const auto& l : _startLinks)
+                fn(base + l.first, l.second);
+            if (_direct != cInf)
+                fn(_G, _direct);
+            return;
+        }
+
+        const int id = _h->clusterOfNode(u);
+        const PathHierarchy::Cluster& cl = _h->cluster(id);
+        const std::uint32_t base = _h->base(id);
+        const std::uint32_t i = u - base;
+        const std::size_t n = cl.nodes.size();
+        const std::uint32_t* row = cl.dist.data() + std::size_t(i) * n;
+        for (std::size_t j = 0; j < n; j++)
+            if (row[j] != cInf && j != i)
+                fn(base + std::uint32_t(j), row[j]);
+        for (std::uint32_t k = cl.firstLink[i]; k < cl.firstLink[i + 1]; k++)
+        {
+            const PathHierarchy::Link& l = cl.links[k];
+            fn(_h->base(int(l.cluster)) + l.node, l.cost);
+        }
+        if (id == _goalCluster && _goalDist[i] != cInf)
+            fn(_G, _goalDist[i]);
+    }
+
+public:
+    // Joins start and goal to the graph and queues the start. The hierarchy
+    // must match the grid and stay unchanged until the query is done.
+    template <class OnQueue>
+    void begin(const PathHierarchy& h, Cell start, Cell goal, OnQueue&& onQueue)
+    {
+        _h = &h;
+        _local.setup(h.grid(), h.diagonal(), h.corners());
+        _start = start;
+        _goal = goal;
+        _startCluster = h.clusterOf(start.r, start.c);
+        _goalCluster = h.clusterOf(goal.r, goal.c);
+        _S = h.nodeCount();
+        _G = _S + 1;
+        _done = false;
+        _found = false;
+        _route.clear();
+
+        const std::size_t n = std::size_t(_G) + 1;
+        if (_g.size() < n)
+        {
+            _g.resize(n);
+            _parent.resize(n);
+            _seen.assign(n, 0);
+            _closed.assign(n, 0);
+            _stamp = 0;
+        }
+        if (++_stamp == 0)
+        {
+            std::fill(_seen.begin(), _seen.end(), 0);
+            std::fill(_closed.begin(), _closed.end(), 0);
+            _stamp = 1;
+        }
+        _heap.clear();
+
+        const Grid& grid = h.grid();
+        const PathHierarchy::Cluster& sc = h.cluster(_startCluster);
+        _local.run(h.clusterRect(_startCluster), start, nullptr);
+        _startLinks.clear();
+        for (std::size_t j = 0; j < sc.nodes.size(); j++)
+        {
+            const std::uint32_t d = _local.dist(grid.cellAt(sc.nodes[j]));
+            if (d != cInf) _startLinks.push_back({std::uint32_t(j), d});
+        }
+
+        // distances are symmetric, so the goal's sweep gives node-to-goal costs
+        const PathHierarchy::Cluster& gc = h.cluster(_goalCluster);
+        _local.run(h.clusterRect(_goalCluster), goal, nullptr);
+        _goalDist.resize(gc.nodes.size());
+        for (std::size_t j = 0; j < gc.nodes.size(); j++)
+            _goalDist[j] = _local.dist(grid.cellAt(gc.nodes[j]));
+
+        // close queries: a path that stays inside both clusters needs no
+        // transition, which would be a detour at this range
+        _direct = cInf;
+        const CellRect sr = h.clusterRect(_startCluster), gr = h.clusterRect(_goalCluster);
+        if (std::abs(sr.r0 - gr.r0) <= h.clusterSize() && std::abs(sr.c0 - gr.c0) <= h.clusterSize())
+        {
+            _directRect = {std::min(sr.r0, gr.r0), std::min(sr.c0, gr.c0), std::max(sr.r1, gr.r1), std::max(sr.c1, gr.c1)};
+            _direct = _local.run(_directRect, start, &goal);
+        }
+
+        _seen[_S] = _stamp;
+        _g[_S] = 0;
+        _parent[_S] = _S;
+        _heap.emplace_back(estimate(start), 0, _S);
+        onQueue(start);
+    }
+
+    bool done() const { return _done; }
+    bool found() const { return _found; }
+
+    // Expands one abstract node. Calls onExpand(cell) for it and
+    // onQueue(cell) for the nodes it queues.
+    template <class OnExpand, class OnQueue>
+    void step(OnExpand&& onExpand, OnQueue&& onQueue)
+    {
+        while (!_heap.empty())
+        {
+            std::pop_heap(_heap.begin(), _heap.end(), std::greater<HierarchyEntry>());
+            const std::uint32_t u = _heap.back().id;
+            _heap.pop_back();
+            if (_closed[u] == _stamp) continue;
+            _closed[u] = _stamp;
+
+            if (u == _G)
+            {
+                for (std::uint32_t v = _G; v != _S; v = _parent[v])
+                    _route.push_back(v);
+                _route.push_back(_S);
+                std::reverse(_route.begin(), _route.end());
+                _done = _found = true;
+                return;
+            }
+            onExpand(nodeCell(u));
+            const std::uint32_t gu = _g[u];
+            forEdges(u, [&](std::uint32_t v, std::uint32_t cost)
+            {
+                const std::uint32_t ng = gu + cost;
+                const bool fresh = _seen[v] != _stamp;
+                if (!fresh && (ng >= _g[v] || _closed[v] == _stamp)) return;
+                _seen[v] = _stamp;
+                _g[v] = ng;
+                _parent[v] = u;
+                const Cell cell = nodeCell(v);
+                _heap.emplace_back(ng + estimate(cell), ng, v);
+                std::push_heap(_heap.begin(), _heap.end(), std::greater<HierarchyEntry>());
+                if (fresh) onQueue(cell);
+            });
+            return;
+        }
+        _done = true;
+    }
+
+    std::size_t queueSize() const { return _heap.size(); }
+
+    // Cost of the path once found
+    std::uint32_t cost() const { return _found ? _g[_G] : cInf; }
+
+    // Abstract path once found: segments() + 1 cells from start to goal
+    std::size_t segments() const { return _route.empty() ? 0 : _route.size() - 1; }
+    Cell waypoint(std::size_t k) const { return nodeCell(_route[k]); }
+
+    // Appends the cells of segment k after its first waypoint
+    void refine(std::size_t k, std::vector<Cell>& out)
+    {
+        const Cell a = nodeCell(_route[k]), b = nodeCell(_route[k + 1]);
+        if (_route[k] == _S && _route[k + 1] == _G)
+        {
+            _local.run(_directRect, a, &b);
+            _local.appendPath(b, out);
+            return;
+        }
+        const int ca = _h->clusterOf(a.r, a.c), cb = _h->clusterOf(b.r, b.c);
+        if (ca != cb)
+        {
+            out.push_back(b);
+            return;
+        }
+        _local.run(_h->clusterRect(ca), a, &b);
+        _local.appendPath(b, out);
+    }
+
+    // The whole refined path, start and goal included. False (out empty)
+    // if cancelled part way; checked every few segments.
+    bool path(std::vector<Cell>& out, CancelFlag cancel = nullptr)
+    {
+        out.clear();
+        if (!_found) return true;
+        out.push_back(_start);
+        for (std::size_t k = 0; k < segments(); k++)
+        {
+            if ((k & 15) == 15 && cancelled(cancel))
+            {
+                out.clear();
+                return false;
+            }
+            refine(k, out);
+        }
+        return true;
+    }
+
+    // Cells settled by the local searches (joining start / goal and refining)
+    std::uint64_t localExpansions() const { return _local.expansions(); }
+    void resetLocalExpansions() { _local.resetExpansions(); }
+
+    std::size_t bytes() const
+    {
+        return (_g.capacity() + _parent.capacity() + _seen.capacity() + _closed.capacity() + _goalDist.capacity()) *
+                   sizeof(std::uint32_t) +
+               _heap.capacity() * sizeof(HierarchyEntry) + _local.bytes();
+    }
+};
+
+} // namespace maze
@@ -0,0 +1,351 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <limits>
+#include <algorithm>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+
+#include "Grid.h"
+
+namespace maze
+{
+
+// Jump Point Search successor generation (Harabor & Grastien) on a Grid.
+//
+// 8-connected mode follows the same movement model as the plain search:
+// diagonal moves are allowed whenever the target cell is free. 4-connected
+// mode treats vertical moves like diagonals: a vertical jump scans horizontally
+// at every cell and stops where a horizontal jump finds something.
+//
+// JPS+: buildTable() precomputes, for every cell and direction, the distance to
+// the next goal-independent jump point (> 0) or the number of free steps before
+// the run is blocked (<= 0). Jumps then become table lookups plus an O(1) check
+// whether the goal lies on the way. The table costs 2 bytes per cell and
+// direction, and must be rebuilt when walls change (see tableMatches()). It is
+// immutable once built, so several instances (threads) can share one copy.
+class JumpPoints
+{
+    const Grid* _grid = nullptr;
+    bool _diagonal = false;
+    Cell _goal;
+
+    using Table = std::vector<std::int16_t>;
+    std::shared_ptr<const Table> _table;   // cells * 8
+    bool _hasTable = false;
+    bool _tableDiagonal = false;
+    std::uint64_t _tableGeneration = 0;     // Grid::generation() of the walls it describes
+
+    bool free(int r, int c) const { return !_grid->isWall(r, c); }
+
+    bool isGoal(int r, int c) const { return r == _goal.r && c == _goal.c; }
+
+    // Directions that scan sideways while they advance
+    bool isScan(int dr, int dc) const { return _diagonal ? (dr != 0 && dc != 0) : (dc == 0); }
+
+    bool canStep(int r, int c, int dr, int dc) const { return free(r + dr, c + dc); }
+
+    // (r,c) was entered moving (dr,dc): does it have a forced neighbor?
+    bool forced(int r, int c, int dr, int dc) const
+    {
+        if (_diagonal)
+        {
+            if (dr != 0 && dc != 0)
+                return (free(r + dr, c - dc) && !free(r, c - dc)) || (free(r - dr, c + dc) && !free(r - dr, c));
+            if (dc != 0)
+                return (free(r + 1, c + dc) && !free(r + 1, c)) || (free(r - 1, c + dc) && !free(r - 1, c));
+            return (free(r + dr, c + 1) && !free(r, c + 1)) || (free(r + dr, c - 1) && !free(r, c - 1));
+        }
+        if (dc != 0)
+            return (free(r - 1, c) && !free(r - 1, c - dc)) || (free(r + 1, c) && !free(r + 1, c - dc));
+        return (free(r, c - 1) && !free(r - dr, c - 1)) || (free(r, c + 1) && !free(r - dr, c + 1));
+    }
+
+    int entry(std::size_t i, int dir) const { return (*_table)[i * 8 + std::size_t(dir)]; }
+    int entry(int r, int c, int dir) const { return entry(_grid->index(r, c), dir); }
+
+    // Free steps available from (r,c) in dir according to the table
+    int reach(int r, int c, int dir) const
+    {
+        int t = entry(r, c, dir);
+        return t > 0 ? t : -t;
+    }
+
+    bool jumpStraight(int r, int c, int dr, int dc, Cell& out) const
+    {
+        for (;;)
+        {
+            if (!canStep(r, c, dr, dc)) return false;
+            r += dr; c += dc;
+            if (isGoal(r, c) || forced(r, c, dr, dc))
+            {
+                out = {r, c};
+                return true;
+            }
+        }
+    }
+
+    bool jumpScan(int r, int c, int dr, int dc, Cell& out) const
+    {
+        Cell tmp;
+        for (;;)
+        {
+            if (!canStep(r, c, dr, dc)) return false;
+            r += dr; c += dc;
+            if (isGoal(r, c) || forced(r, c, dr, dc))
+            {
+                out = {r, c};
+                return true;
+            }
+            bool found = _diagonal
+                ? (jumpStraight(r, c, 0, dc, tmp) || jumpStraight(r, c, dr, 0, tmp))
+                : (jumpStraight(r, c, 0, 1, tmp) || jumpStraight(r, c, 0, -1, tmp));
+            if (found)
+            {
+                out = {r, c};
+                return true;
+            }
+        }
+    }
+
+    // k > 0 if the goal is k steps from (r,c) along (dr,dc), else 0
+    int stepsToGoal(int r, int c, int dr, int dc) const
+    {
+        int kr = (_goal.r - r) * dr;
+        int kc = (_goal.c - c) * dc;
+        if (dr == 0) return (_goal.r == r && kc > 0) ? kc : 0;
+        if (dc == 0) return (_goal.c == c && kr > 0) ? kr : 0;
+        return (kr == kc && kr > 0) ? kr : 0;
+    }
+
+    bool jumpTable(int r, int c, int dr, int dc, Cell& out) const
+    {
+        const int dir = dirIndex(dr, dc);
+        const int t = entry(r, c, dir);
+        const int maxReach = t > 0 ? t : -t;
+        int best = t > 0 ? t : std::numeric_limits<int>::max();
+
+        // goal on the run itself
+        int k = stepsToGoal(r, c, dr, dc);
+        if (k > 0 && k <= maxReach)
+            best = std::min(best, k);
+
+        if (isScan(dr, dc))
+        {
+            // goal reachable by one of the sideways jumps made along the run
+            if (dr != 0)
+            {
+                int k1 = (_goal.r - r) * dr;    // step that reaches the goal row
+                if (k1 > 0 && k1 <= maxReach && k1 < best)
+                {
+                    int yc = c + k1 * dc;
+                    int m = _goal.c - yc;
+                    int side = m > 0 ? 1 : -1;
+                    if (m != 0 && (_diagonal ? side == dc : true) && (m * side) <= reach(_goal.r, yc, dirIndex(0, side)))
+                        best = k1;
+                }
+            }
+            if (_diagonal)
+            {
+                int k2 = (_goal.c - c) * dc;    // step that reaches the goal column
+                if (k2 > 0 && k2 <= maxReach && k2 < best)
+                {
+                    int yr = r + k2 * dr;
+                    int m = (_goal.r - yr) * dr;
+                    if (m > 0 && m <= reach(yr, _goal.c, dirIndex(dr, 0)))
+                        best = k2;
+                }
+            }
+        }
+
+        if (best == std::numeric_limits<int>::max())
+            return false;
+        out = {r + best * dr, c + best * dc};
+        return true;
+    }
+
+    bool jump(int r, int c, int dr, int dc, Cell& out) const
+    {
+        if (_hasTable)
+            return jumpTable(r, c, dr, dc, out);
+        if (isScan(dr, dc))
+            return jumpScan(r, c, dr, dc, out);
+        return jumpStraight(r, c, dr, dc, out);
+    }
+
+public:
+    // Sets the grid, movement model and goal for the next search. The JPS+
+    // table is used only if requested and still valid for this grid.
+    void setup(const Grid& grid, Cell goal, bool diagonal, bool useTable)
+    {
+        _grid = &grid;
+        _diagonal = diagonal;
+        _goal = goal;
+        _hasTable = useTable && tableMatches();
+    }
+
+    bool diagonal() const { return _diagonal; }
+
+    // Is the JPS+ table built for the current walls and movement model?
+    bool tableMatches() const
+    {
+        return _table && _tableGeneration == _grid->generation() && _tableDiagonal == _diagonal;
+    }
+
+    bool hasTable() const { return _hasTable; }
+    void dropTable() { _table.reset(); _hasTable = false; _tableGeneration = 0; }
+    std::size_t tableBytes() const { return _table ? _table->size() * sizeof(std::int16_t) : 0; }
+
+    // Adopts the table built by other; used on the next setup() if it matches
+    void shareTable(const JumpPoints& other)
+    {
+        _table = other._table;
+        _tableGeneration = other._tableGeneration;
+        _tableDiagonal = other._tableDiagonal;
+        _hasTable = false;
+    }
+
+    // Precomputes goal-independent jump distances for every cell and
+    // direction; a cancelled build leaves no table
+    void buildTable(CancelFlag cancel = nullptr)
+    {
+        const int R = _grid->rows(), C = _grid->cols();
+        auto table = std::make_shared<Table>();
+        _table = table;
+        _hasTable = false;
+        if (!assignCancellable(*table, _grid->size() * 8, std::int16_t(0), cancel))
+        {
+            dropTable();
+            return;
+        }
+        auto at = [&](std::size_t i, int dir) -> std::int16_t& { return (*table)[i * 8 + std::size_t(dir)]; };
+
+        const int nDirs = _diagonal ? 8 : 4;
+        // straight runs first; scanning runs read them
+        for (int pass = 0; pass < 2; pass++)
+        {
+            for (int dir = 0; dir < nDirs; dir++)
+            {
+                const int dr = cDirR[dir], dc = cDirC[dir];
+                const bool scan = isScan(dr, dc);
+                if (scan != (pass == 1)) continue;
+
+                // visit (r+dr, c+dc) before (r,c)
+                for (int ri = 0; ri < R; ri++)
+                {
+                    if (cancelled(cancel))
+                    {
+                        dropTable();
+                        return;
+                    }
+                    const int r = (dr > 0) ? R - 1 - ri : ri;
+                    for (int ci = 0; ci < C; ci++)
+                    {
+                        const int c = (dc > 0) ? C - 1 - ci : ci;
+                        if (!free(r, c)) continue;
+
+                        std::int16_t& t = at(_grid->index(r, c), dir);
+                        if (!canStep(r, c, dr, dc))
+                        {
+                            t = 0;
+                            continue;
+                        }
+                        const int nr = r + dr, nc = c + dc;
+                        bool stop = forced(nr, nc, dr, dc);
+                        if (!stop && scan)
+                        {
+                            stop = _diagonal
+                                ? (entry(nr, nc, dirIndex(0, dc)) > 0 || entry(nr, nc, dirIndex(dr, 0)) > 0)
+                                : (entry(nr, nc, dirIndex(0, 1)) > 0 || entry(nr, nc, dirIndex(0, -1)) > 0);
+                        }
+                        if (stop)
+                        {
+                            t = 1;
+                            continue;
+                        }
+                        int next = entry(nr, nc, dir);
+                        t = std::int16_t(next > 0 ? next + 1 : next - 1);
+                    }
+                }
+            }
+        }
+
+        _tableGeneration = _grid->generation();
+        _tableDiagonal = _diagonal;
+        _hasTable = true;
+    }
+
+    // Calls emit(jumpPoint, dir, steps) for every successor of cur.
+    // parentDir is the direction cur was reached with (-1 at the start).
+    template <class Emit>
+    void successors(Cell cur, int parentDir, Emit&& emit) const
+    {
+        const int r = cur.r, c = cur.c;
+        int dirs[8];
+        int n = 0;
+
+        auto add = [&](int dr, int dc) { dirs[n++] = dirIndex(dr, dc); };
+
+        if (parentDir < 0)
+        {
+            const int nDirs = _diagonal ? 8 : 4;
+            for (int dir = 0; dir < nDirs; dir++)
+                dirs[n++] = dir;
+        }
+        else
+        {
+            const int dr = cDirR[parentDir], dc = cDirC[parentDir];
+            if (_diagonal)
+            {
+                if (dr != 0 && dc != 0)
+                {
+                    add(dr, 0);
+                    add(0, dc);
+                    add(dr, dc);
+                    if (!free(r, c - dc)) add(dr, -dc);
+                    if (!free(r - dr, c)) add(-dr, dc);
+                }
+                else if (dc == 0)
+                {
+                    add(dr, 0);
+                    if (!free(r, c + 1)) add(dr, 1);
+                    if (!free(r, c - 1)) add(dr, -1);
+                }
+                else
+                {
+                    add(0, dc);
+                    if (!free(r + 1, c)) add(1, dc);
+                    if (!free(r - 1, c)) add(-1, dc);
+                }
+            }
+            else
+            {
+                if (dc != 0)
+                {
+                    add(-1, 0);
+                    add(1, 0);
+                    add(0, dc);
+                }
+                else
+                {
+                    add(0, -1);
+                    add(0, 1);
+                    add(dr, 0);
+                }
+            }
+        }
+
+        Cell jp;
+        for (int k = 0; k < n; k++)
+        {
+            const int dir = dirs[k];
+            const int dr = cDirR[dir], dc = cDirC[dir];
+            if (!canStep(r, c, dr, dc)) continue;
+            if (jump(r, c, dr, dc, jp))
+                emit(jp, dir, std::max(std::abs(jp.r - r), std::abs(jp.c - c)));
+        }
+    }
+};
+
+} // namespace maze
@@ -0,0 +1,248 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "Grid.h"
+#include "MazeTypes.h"
+#include "CostSweep.h"
+
+namespace maze
+{
+
+// ALT heuristic tables (A*, Landmarks, Triangle inequality; Goldberg &
+// Harrelson). For each of K landmark cells the exact path cost to every
+// cell is stored, and for any cells v, t and landmark L
+//     cost(v, t) >= |d(L, v) - d(L, t)|
+// since moves are symmetric. The largest of these bounds is a consistent
+// heuristic that knows about the walls, unlike the geometric ones.
+//
+// Costs are stored K per cell side by side, so one estimate reads one
+// cache line per cell, as uint16 when they fit and as uint32 (wide) when
+// they may not. Every landmark lies in the component of the first sweep's
+// source s, so no cost exceeds twice the largest cost from s; the table is
+// wide when that is above cMaxNarrow. Either way the costs are exact.
+//
+// Landmarks are picked by farthest selection: the first is the cell
+// farthest from the grid's start, each next one the cell farthest from all
+// landmarks so far. The tables describe one grid version; after an edit
+// matches() is false and the owner rebuilds them when they are next needed.
+class LandmarkTable
+{
+public:
+    static constexpr int cDefaultCount = 8;
+    static constexpr int cMaxCount = 32;
+    static constexpr std::uint16_t cMaxNarrow = 0xFFFE;   // largest cost of a uint16 table
+    static constexpr std::uint16_t cUnreached = 0xFFFF;
+    static constexpr std::uint32_t cUnreachedWide = CostSweep::cInf;
+
+private:
+    static constexpr std::uint32_t cInf = CostSweep::cInf;
+
+    const Grid* _grid = nullptr;
+    bool _diagonal = false;
+    CornerRule _corners = CornerRule::Cut;
+    int _count = 0;
+    int _cols = 0;
+    std::uint64_t _generation = 0;
+    bool _valid = false;
+    bool _wide = false;
+
+    std::vector<Cell> _landmarks;
+    std::vector<std::uint16_t> _dist;       // [cell * _count + k]
+    std::vector<std::uint32_t> _wideDist;   // same layout; only one of the two is used
+
+    CostSweep _sweep;
+
+    // Reached cell with the largest key(i), or src if none is farther
+    template <class Key>
+    Cell farthest(Cell src, Key&& key) const
+    {
+        const std::vector<std::uint32_t>& g = _sweep.costs();
+        std::size_t best = _grid->index(src);
+        std::uint32_t bestKey = 0;
+        for (std::size_t i = 0; i < g.size(); i++)
+        {
+            if (g[i] == cInf) continue;
+            const std::uint32_t k = key(i);
+            if (k > bestKey)
+            {
+                bestKey = k;
+                best = i;
+            }
+        }
+        return _grid->cellAt(best);
+    }
+
+    template <class T>
+    std::uint32_t boundOf(const std::vector<T>& dist, std::size_t a, std::size_t b, T unreached) const
+    {
+        const T* da = dist.data() + a * std::size_t(_count);
+        const T* db = dist.data() + b * std::size_t(_count);
+        std::uint32_t best = 0;
+        for (int k = 0; k < _count; k++)
+        {
+            // a landmark that cannot reach both cells says nothing about them
+            if (da[k] == unreached || db[k] == unreached) continue;
+            const std::uint32_t x = da[k], y = db[k];
+            best = std::max(best, x > y ? x - y : y - x);
+        }
+        return best;
+    }
+
+    std::size_t entries() const { return _wide ? _wideDist.size() : _dist.size(); }
+
+    void restoreCommon(const Grid& grid, bool diagonal, CornerRule corners, int count, const Cell* landmarks)
+    {
+        _grid = &grid;
+        _diagonal = diagonal;
+        _corners = corners;
+        _count = std::max(1, std::min(count, cMaxCount));
+        _cols = grid.cols();
+        _generation = grid.generation();
+        _valid = true;
+        _landmarks.assign(landmarks, landmarks + _count);
+    }
+
+public:
+    // Picks count landmarks and measures the path costs from each of them
+    // for the movement model. A cancelled build leaves the tables invalid.
+    void build(const Grid& grid, bool diagonal, CornerRule corners, int count = cDefaultCount, CancelFlag cancel = nullptr)
+    {
+        _grid = &grid;
+        _diagonal = diagonal;
+        _corners = corners;
+        _count = std::max(1, std::min(count, cMaxCount));
+        _cols = grid.cols();
+        _generation = grid.generation();
+        _valid = true;
+        _wide = false;
+        _landmarks.clear();
+        _wideDist.clear();
+
+        const std::size_t n = std::size_t(grid.rows()) * std::size_t(grid.cols());
+        Cell seed = grid.start();
+        if (grid.isWall(seed))
+        {
+            std::size_t i = 0;
+            while (i < n && grid.isWall(grid.cellAt(i))) i++;
+            if (i == n)
+            {
+                _dist.assign(n * std::size_t(_count), cUnreached);
+                return;     // no free cell: every bound is 0
+            }
+            seed = grid.cellAt(i);
+        }
+
+        // nearest landmark distance per cell, for farthest selection
+        std::vector<std::uint32_t> nearest;
+        const std::vector<std::uint32_t>& g = _sweep.costs();
+        if (!assignCancellable(nearest, n, cInf, cancel) || !_sweep.run(grid, seed, diagonal, corners, nullptr, cancel))
+        {
+            _valid = false;
+            return;
+        }
+        std::uint64_t radius = 0;
+        for (std::uint32_t d : g)
+            if (d != cInf) radius = std::max<std::uint64_t>(radius, d);
+        _wide = 2 * radius > cMaxNarrow;
+        _dist.clear();
+        const bool filled = _wide ? assignCancellable(_wideDist, n * std::size_t(_count), cUnreachedWide, cancel)
+                                  : assignCancellable(_dist, n * std::size_t(_count), cUnreached, cancel);
+        if (!filled)
+        {
+            _valid = false;
+            return;
+        }
+
+        Cell next = farthest(seed, [&](std::size_t i) { return g[i]; });
+        for (int k = 0; k < _count; k++)
+        {
+            _landmarks.push_back(next);
+            if (!_sweep.run(grid, next, diagonal, corners, nullptr, cancel))
+            {
+                _valid = false;
+                return;
+            }
+            for (std::size_t i = 0; i < n; i++)
+            {
+                if (g[i] == cInf) continue;
+                const std::size_t at = i * std::size_t(_count) + std::size_t(k);
+                if (_wide) _wideDist[at] = g[i];
+                else _dist[at] = std::uint16_t(g[i]);
+                nearest[i] = std::min(nearest[i], g[i]);
+            }
+            next = farthest(next, [&](std::size_t i) { return nearest[i]; });
+        }
+        _sweep.release();
+    }
+
+    // True if the tables describe this grid as it is now, for this movement model
+    bool matches(const Grid& grid, bool diagonal, CornerRule corners, int count) const
+    {
+        return _valid && _grid == &grid && _generation == grid.generation() && _diagonal == diagonal && _corners == corners &&
+               _count == std::max(1, std::min(count, cMaxCount)) && _cols == grid.cols() &&
+               entries() == std::size_t(grid.rows()) * std::size_t(grid.cols()) * std::size_t(_count);
+    }
+
+    // Same, for whichever movement model and count the tables were built for
+    bool matches(const Grid& grid) const
+    {
+        return matches(grid, _diagonal, _corners, _count);
+    }
+
+    // Takes over saved tables (landmarks() and distances() or
+    // wideDistances() of a table built for the grid as it is now) instead
+    // of build()
+    void restore(const Grid& grid, bool diagonal, CornerRule corners, int count, const Cell* landmarks, const std::uint16_t* dist)
+    {
+        restoreCommon(grid, diagonal, corners, count, landmarks);
+        _wide = false;
+        _dist.assign(dist, dist + grid.size() * std::size_t(_count));
+        _wideDist.clear();
+    }
+
+    void restore(const Grid& grid, bool diagonal, CornerRule corners, int count, const Cell* landmarks, const std::uint32_t* dist)
+    {
+        restoreCommon(grid, diagonal, corners, count, landmarks);
+        _wide = true;
+        _wideDist.assign(dist, dist + grid.size() * std::size_t(_count));
+        _dist.clear();
+    }
+
+    // Lower bound on the path cost between cells a and b (row-major indices)
+    std::uint32_t bound(std::size_t a, std::size_t b) const
+    {
+        if (_wide)
+            return boundOf(_wideDist, a, b, cUnreachedWide);
+        return boundOf(_dist, a, b, cUnreached);
+    }
+
+    std::uint32_t bound(int r, int c, const Cell& to) const
+    {
+        return bound(std::size_t(r) * std::size_t(_cols) + std::size_t(c), std::size_t(to.r) * std::size_t(_cols) + std::size_t(to.c));
+    }
+
+    // Drops all memory; matches() is false until the next build()
+    void release()
+    {
+        *this = LandmarkTable();
+    }
+
+    int count() const { return _count; }
+    bool diagonal() const { return _diagonal; }
+    CornerRule corners() const { return _corners; }
+    // Costs from each landmark, count() per cell side by side: distances()
+    // if the table is narrow, wideDistances() if wide()
+    bool wide() const { return _wide; }
+    const std::vector<std::uint16_t>& distances() const { return _dist; }
+    const std::vector<std::uint32_t>& wideDistances() const { return _wideDist; }
+    const std::vector<Cell>& landmarks() const { return _landmarks; }
+    std::size_t bytes() const
+    {
+        return _dist.capacity() * sizeof(std::uint16_t) + _wideDist.capacity() * sizeof(std::uint32_t) + _landmarks.capacity() * sizeof(Cell);
+    }
+};
+
+} // namespace maze
@@ -0,0 +1,96 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace maze
+{
+
+// A whole file mapped into memory copy-on-write: pages are read from the
+// file only when first touched, and writes go to private copies of the
+// pages, never back to the file. Mapping is O(1) in the file size.
+class MappedFile
+{
+    void* _data = nullptr;
+    std::size_t _size = 0;
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const std::string& path)
+    {
+        close();
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0)
+        {
+            CloseHandle(file);
+            return false;
+        }
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (!mapping)
+            return false;
+        void* view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+        CloseHandle(mapping);     // the view keeps the mapping alive
+        if (!view)
+            return false;
+        _data = view;
+        _size = std::size_t(size.QuadPart);
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size <= 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        void* view = ::mmap(nullptr, std::size_t(st.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        ::close(fd);              // the mapping keeps the file open
+        if (view == MAP_FAILED)
+            return false;
+        _data = view;
+        _size = std::size_t(st.st_size);
+#endif
+        return true;
+    }
+
+    void close()
+    {
+        if (!_data)
+            return;
+#ifdef _WIN32
+        UnmapViewOfFile(_data);
+#else
+        ::munmap(_data, _size);
+#endif
+        _data = nullptr;
+        _size = 0;
+    }
+
+    bool isOpen() const { return _data != nullptr; }
+    // Page aligned
+    unsigned char* data() const { return static_cast<unsigned char*>(_data); }
+    std::size_t size() const { return _size; }
+};
+
+} // namespace maze
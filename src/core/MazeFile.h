@@ -0,0 +1,290 @@
+#pragma once
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+
+#include "Grid.h"
+#include "Connectivity.h"
+#include "Landmarks.h"
+#include "MappedFile.h"
+
+namespace maze
+{
+
+// Binary maze format, laid out to be memory-mapped:
+//
+//   header          64 bytes (MazeFileHeader)
+//   section table   sectionCount x 32 bytes (MazeFileSection)
+//   walls           at wallOffset: the grid's BitGrid words, wall border included
+//   sections        derived indexes, each at its own offset
+//
+// Every payload starts on a 64-byte boundary. Numbers are stored in the byte
+// order of the machine that wrote the file; readers reject other orders
+// through endianTag. Readers skip sections they do not know, and reject
+// files of a newer format version.
+//
+// loadMaze() maps the file and points the grid at the walls where they lie
+// in the mapping: nothing is parsed or copied, so a maze of 100M cells opens
+// as fast as a small one. Pages are read from disk when first touched, and
+// edits go to private copies of them, never to the file. Sections are copied
+// out of the mapping into the indexes they restore.
+struct MazeFileHeader
+{
+    char magic[8];                  // cMazeFileMagic
+    std::uint32_t version;          // cMazeFileVersion
+    std::uint32_t endianTag;        // cMazeFileEndianTag, in the writer's byte order
+    std::int32_t rows;
+    std::int32_t cols;
+    std::int32_t startR;
+    std::int32_t startC;
+    std::int32_t goalR;
+    std::int32_t goalC;
+    std::uint32_t seed;             // generator seed, 0 if unknown
+    std::uint32_t sectionCount;
+    std::uint64_t wallOffset;
+    std::uint64_t wallWords;        // BitGrid::wordsFor(rows, cols)
+};
+static_assert(sizeof(MazeFileHeader) == 64, "header layout");
+
+enum class MazeSection : std::uint32_t
+{
+    Components = 1,     // uint32 component id per cell (ConnectivityIndex::denseLabels)
+    Landmarks = 2       // count landmark cells, then uint16 costs (LandmarkTable::distances), uint32 if wide
+};
+
+struct MazeFileSection
+{
+    std::uint32_t tag;              // MazeSection
+    std::uint32_t flags;            // Components: 1 = 8-connected; Landmarks: diagonal | corners << 1 | wide << 3
+    std::uint32_t count;            // components / landmarks
+    std::uint32_t reserved;
+    std::uint64_t offset;
+    std::uint64_t bytes;
+};
+static_assert(sizeof(MazeFileSection) == 32, "section layout");
+static_assert(sizeof(Cell) == 8, "landmark cells are stored as two int32");
+
+constexpr char cMazeFileMagic[8] = {'M', 'A', 'Z', 'E', 'B', 'I', 'N', '\0'};
+constexpr std::uint32_t cMazeFileVersion = 1;
+constexpr std::uint32_t cMazeFileEndianTag = 0x01020304u;
+constexpr std::uint64_t cMazeFileAlign = 64;
+
+// What saveMaze() stores besides the grid
+struct MazeFileExtras
+{
+    unsigned seed = 0;
+    const ConnectivityIndex* components = nullptr;  // stored if it describes the grid as it is
+    const LandmarkTable* landmarks = nullptr;       // likewise
+};
+
+// What loadMaze() found besides the grid
+struct MazeFileInfo
+{
+    unsigned seed = 0;
+    bool components = false;        // the components index was restored
+    bool landmarks = false;         // the landmark tables were restored
+};
+
+namespace detail
+{
+
+inline std::uint64_t alignUp(std::uint64_t n) { return (n + cMazeFileAlign - 1) / cMazeFileAlign * cMazeFileAlign; }
+
+inline void writePadding(std::ofstream& out, std::uint64_t to)
+{
+    static const char zeros[cMazeFileAlign] = {};
+    const std::uint64_t at = std::uint64_t(out.tellp());
+    if (to > at)
+        out.write(zeros, std::streamsize(to - at));
+}
+
+} // namespace detail
+
+// True if the file starts like a binary maze file
+inline bool isMazeFile(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    char magic[sizeof(cMazeFileMagic)] = {};
+    return in.read(magic, sizeof(magic)) && std::memcmp(magic, cMazeFileMagic, sizeof(magic)) == 0;
+}
+
+// Writes a temporary file and renames it over path, so a crash never leaves
+// half a file, and a grid that views the old file keeps reading it
+inline bool saveMaze(const std::string& path, const Grid& grid, const MazeFileExtras& extras = MazeFileExtras())
+{
+    const BitGrid& walls = grid.walls();
+    const std::size_t cells = grid.size();
+    const bool hasComponents = extras.components && extras.components->matches(grid);
+    const bool hasLandmarks = extras.landmarks && extras.landmarks->matches(grid);
+
+    MazeFileHeader h{};
+    std::memcpy(h.magic, cMazeFileMagic, sizeof(h.magic));
+    h.version = cMazeFileVersion;
+    h.endianTag = cMazeFileEndianTag;
+    h.rows = grid.rows();
+    h.cols = grid.cols();
+    h.startR = grid.start().r;
+    h.startC = grid.start().c;
+    h.goalR = grid.goal().r;
+    h.goalC = grid.goal().c;
+    h.seed = extras.seed;
+    h.sectionCount = std::uint32_t(hasComponents) + std::uint32_t(hasLandmarks);
+    h.wallOffset = detail::alignUp(sizeof(MazeFileHeader) + h.sectionCount * sizeof(MazeFileSection));
+    h.wallWords = walls.wordCount();
+
+    std::vector<MazeFileSection> table;
+    std::uint64_t end = h.wallOffset + h.wallWords * sizeof(std::uint64_t);
+    if (hasComponents)
+    {
+        MazeFileSection s{};
+        s.tag = std::uint32_t(MazeSection::Components);
+        s.flags = extras.components->diagonal() ? 1u : 0u;
+        s.count = std::uint32_t(extras.components->componentCount());
+        s.offset = detail::alignUp(end);
+        s.bytes = cells * sizeof(std::uint32_t);
+        end = s.offset + s.bytes;
+        table.push_back(s);
+    }
+    if (hasLandmarks)
+    {
+        const LandmarkTable& lm = *extras.landmarks;
+        MazeFileSection s{};
+        s.tag = std::uint32_t(MazeSection::Landmarks);
+        s.flags = (lm.diagonal() ? 1u : 0u) | (std::uint32_t(lm.corners()) << 1) | (lm.wide() ? 8u : 0u);
+        s.count = std::uint32_t(lm.count());
+        s.offset = detail::alignUp(end);
+        s.bytes = lm.landmarks().size() * sizeof(Cell) +
+                  (lm.wide() ? lm.wideDistances().size() * sizeof(std::uint32_t) : lm.distances().size() * sizeof(std::uint16_t));
+        end = s.offset + s.bytes;
+        table.push_back(s);
+    }
+
+    const std::string tmp = path + ".tmp";
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out)
+        return false;
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    out.write(reinterpret_cast<const char*>(table.data()), std::streamsize(table.size() * sizeof(MazeFileSection)));
+    detail::writePadding(out, h.wallOffset);
+    out.write(reinterpret_cast<const char*>(walls.words()), std::streamsize(h.wallWords * sizeof(std::uint64_t)));
+    for (const MazeFileSection& s : table)
+    {
+        detail::writePadding(out, s.offset);
+        if (s.tag == std::uint32_t(MazeSection::Components))
+        {
+            std::vector<std::uint32_t> labels;
+            extras.components->denseLabels(labels);
+            out.write(reinterpret_cast<const char*>(labels.data()), std::streamsize(labels.size() * sizeof(std::uint32_t)));
+        }
+        else
+        {
+            const LandmarkTable& lm = *extras.landmarks;
+            out.write(reinterpret_cast<const char*>(lm.landmarks().data()), std::streamsize(lm.landmarks().size() * sizeof(Cell)));
+            if (lm.wide())
+                out.write(reinterpret_cast<const char*>(lm.wideDistances().data()), std::streamsize(lm.wideDistances().size() * sizeof(std::uint32_t)));
+            else
+                out.write(reinterpret_cast<const char*>(lm.distances().data()), std::streamsize(lm.distances().size() * sizeof(std::uint16_t)));
+        }
+    }
+    out.close();
+    if (!out)
+    {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    // rename() does not replace an existing file everywhere
+    if (std::rename(tmp.c_str(), path.c_str()) != 0 && (std::remove(path.c_str()) != 0 || std::rename(tmp.c_str(), path.c_str()) != 0))
+    {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Maps the file and makes grid view its walls (see above). The sections the
+// file has are restored into components and landmarks when those are given;
+// info tells which were. False, with everything unchanged, if the file
+// cannot be mapped or is not a valid maze file.
+inline bool loadMaze(const std::string& path, Grid& grid, MazeFileInfo* info = nullptr,
+                     ConnectivityIndex* components = nullptr, LandmarkTable* landmarks = nullptr)
+{
+    auto file = std::make_shared<MappedFile>();
+    if (!file->open(path) || file->size() < sizeof(MazeFileHeader))
+        return false;
+
+    MazeFileHeader h;
+    std::memcpy(&h, file->data(), sizeof(h));
+    if (std::memcmp(h.magic, cMazeFileMagic, sizeof(h.magic)) != 0 || h.version > cMazeFileVersion ||
+        h.endianTag != cMazeFileEndianTag)
+        return false;
+    if (h.rows < Grid::cMinDim || h.cols < Grid::cMinDim || h.rows > Grid::cMaxDim || h.cols > Grid::cMaxDim)
+        return false;
+    const Cell start{h.startR, h.startC}, goal{h.goalR, h.goalC};
+    const std::uint64_t size = file->size();
+    const std::uint64_t cells = std::uint64_t(h.rows) * std::uint64_t(h.cols);
+    const std::uint64_t tableEnd = sizeof(MazeFileHeader) + std::uint64_t(h.sectionCount) * sizeof(MazeFileSection);
+    if (h.wallWords != BitGrid::wordsFor(h.rows, h.cols) || h.wallOffset % cMazeFileAlign != 0 || h.wallOffset < tableEnd ||
+        h.wallOffset > size || h.wallWords > (size - h.wallOffset) / sizeof(std::uint64_t))
+        return false;
+
+    // sections are checked before the grid changes, so a bad file leaves it alone
+    std::vector<MazeFileSection> table(h.sectionCount);
+    std::memcpy(table.data(), file->data() + sizeof(MazeFileHeader), table.size() * sizeof(MazeFileSection));
+    for (const MazeFileSection& s : table)
+        if (s.offset > size || s.bytes > size - s.offset || s.offset % cMazeFileAlign != 0)
+            return false;
+
+    if (start.r < 0 || start.c < 0 || start.r >= h.rows || start.c >= h.cols || goal.r < 0 || goal.c < 0 || goal.r >= h.rows ||
+        goal.c >= h.cols)
+        return false;
+
+    unsigned char* base = file->data();
+    std::uint64_t* words = reinterpret_cast<std::uint64_t*>(base + h.wallOffset);
+    if (!grid.viewWalls(h.rows, h.cols, words, std::move(file)))
+        return false;
+    grid.setStart(start);
+    grid.setGoal(goal);
+
+    MazeFileInfo found;
+    found.seed = h.seed;
+    for (const MazeFileSection& s : table)
+    {
+        const unsigned char* p = base + s.offset;
+        if (s.tag == std::uint32_t(MazeSection::Components) && components)
+        {
+            if (s.bytes == cells * sizeof(std::uint32_t))
+                found.components = components->restore(grid, s.flags & 1u, reinterpret_cast<const std::uint32_t*>(p), s.count);
+        }
+        else if (s.tag == std::uint32_t(MazeSection::Landmarks) && landmarks)
+        {
+            const std::uint64_t count = s.count;
+            const std::uint32_t corners = (s.flags >> 1) & 3u;
+            const bool wide = (s.flags & 8u) != 0;
+            const Cell* cellsOf = reinterpret_cast<const Cell*>(p);
+            bool ok = count >= 1 && count <= std::uint64_t(LandmarkTable::cMaxCount) && corners <= std::uint32_t(CornerRule::NoCut) &&
+                      s.flags < 16u && s.bytes == count * sizeof(Cell) + cells * count * (wide ? sizeof(std::uint32_t) : sizeof(std::uint16_t));
+            for (std::uint64_t k = 0; ok && k < count; k++)
+                ok = grid.inside(cellsOf[k]);
+            if (ok)
+            {
+                if (wide)
+                    landmarks->restore(grid, s.flags & 1u, CornerRule(corners), int(count), cellsOf,
+                                       reinterpret_cast<const std::uint32_t*>(p + count * sizeof(Cell)));
+                else
+                    landmarks->restore(grid, s.flags & 1u, CornerRule(corners), int(count), cellsOf,
+                                       reinterpret_cast<const std::uint16_t*>(p + count * sizeof(Cell)));
+                found.landmarks = true;
+            }
+        }
+    }
+    if (info)
+        *info = found;
+    return true;
+}
+
+} // namespace maze
@@ -0,0 +1,68 @@
+#pragma once
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Grid.h"
+
+namespace maze
+{
+
+// Plain-text maze format, one line per row:
+//   '#' wall, '.' free, 'S' start, 'G' goal
+// Missing S/G default to the top-left / bottom-right corners.
+
+inline bool readText(std::istream& in, Grid& grid)
+{
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line.empty())
+            continue;
+        if (!lines.empty() && line.size() != lines.front().size())
+            return false;
+        lines.push_back(line);
+    }
+    if (lines.empty())
+        return false;
+
+    const int R = (int)lines.size();
+    const int C = (int)lines.front().size();
+    grid.resize(R, C);
+
+    for (int r = 0; r < R; r++)
+    {
+        for (int c = 0; c < C; c++)
+        {
+            switch (lines[r][c])
+            {
+                case '#': grid.setWall(r, c, true); break;
+                case '.': break;
+                case 'S': grid.setStart({r,c}); break;
+                case 'G': grid.setGoal({r,c}); break;
+                default: return false;
+            }
+        }
+    }
+    return true;
+}
+
+inline void writeText(std::ostream& out, const Grid& grid)
+{
+    std::string line;
+    for (int r = 0; r < grid.rows(); r++)
+    {
+        line.assign(grid.cols(), '.');
+        for (int c = 0; c < grid.cols(); c++)
+            if (grid.isWall(r,c)) line[c] = '#';
+        if (grid.start().r == r) line[grid.start().c] = 'S';
+        if (grid.goal().r == r) line[grid.goal().c] = 'G';
+        out << line << '\n';
+    }
+}
+
+} // namespace maze
@@ -0,0 +1,229 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace maze
+{
+
+// Cell indices are computed in size_t (r*cols+c overflows int past 46k x 46k)
+// and stored compactly as 32-bit where a per-cell array holds them.
+using CellIndex = std::uint32_t;
+constexpr CellIndex cNoCell = ~CellIndex(0);
+
+struct Cell { int r=0,c=0; };
+
+inline bool operator==(const Cell& a, const Cell& b) { return a.r == b.r && a.c == b.c; }
+inline bool operator!=(const Cell& a, const Cell& b) { return !(a == b); }
+
+enum class Algorithm : int
+{
+    BFS = 0,
+    Dijkstra = 1,
+    AStar = 2,
+    JPS = 3,        // jump point search (A* over jump points)
+    BidirectionalBFS = 4,
+    BidirectionalAStar = 5,
+    DStarLite = 6,  // incremental: repairs the previous search after wall edits
+    HPAStar = 7     // hierarchical: A* over cluster entrances, then refined
+};
+
+// Move directions: 0-3 orthogonal (N,S,W,E), 4-7 diagonal (NW,NE,SW,SE)
+constexpr int cDirR[8] = {-1, 1, 0, 0, -1, -1, 1, 1};
+constexpr int cDirC[8] = { 0, 0,-1, 1, -1,  1,-1, 1};
+// Bit of each direction in Grid::walls3x3()
+constexpr unsigned cDirBit[8] = {1, 7, 3, 5, 0, 2, 6, 8};
+
+inline int dirIndex(int dr, int dc)
+{
+    if (dc == 0) return dr < 0 ? 0 : 1;
+    if (dr == 0) return dc < 0 ? 2 : 3;
+    return 4 + (dr < 0 ? 0 : 2) + (dc < 0 ? 0 : 1);
+}
+
+inline bool isDiagonalDir(int dir) { return dir >= 4; }
+
+// Move costs in fixed point: tenths of a cell, so a diagonal (sqrt 2 = 1.414)
+// costs 14. Path costs are reported in these units; divide by cCostScale for cells.
+constexpr std::uint32_t cOrthCost = 10;
+constexpr std::uint32_t cDiagCost = 14;
+constexpr double cCostScale = 10.0;
+
+// Cost of one move
+inline std::uint32_t stepCost(int dir) { return isDiagonalDir(dir) ? cDiagCost : cOrthCost; }
+
+// When a diagonal move may pass next to walls (8-connected mode)
+enum class CornerRule : int
+{
+    Cut = 0,        // whenever the target cell is free
+    NoSqueeze = 1,  // not between two walls; passing one wall corner is fine
+    NoCut = 2       // only if both cells beside the move are free
+};
+
+// Walls (bits of Grid::walls3x3()) beside each diagonal move; 0 for orthogonal moves
+constexpr unsigned cSideBits[8] = {0, 0, 0, 0,
+                                   (1u << 1) | (1u << 3), (1u << 1) | (1u << 5),
+                                   (1u << 7) | (1u << 3), (1u << 7) | (1u << 5)};
+
+// True if the move in direction dir from a cell with this walls3x3() mask is allowed
+template <CornerRule Rule>
+inline bool canMove(unsigned walls, int dir)
+{
+    if (walls & (1u << cDirBit[dir])) return false;
+    const unsigned sides = walls & cSideBits[dir];
+    switch (Rule)
+    {
+        case CornerRule::NoCut:     return sides == 0;
+        case CornerRule::NoSqueeze: return sides == 0 || sides != cSideBits[dir];
+        case CornerRule::Cut:
+        default:                    return true;
+    }
+}
+
+inline bool canMove(unsigned walls, int dir, CornerRule rule)
+{
+    switch (rule)
+    {
+        case CornerRule::NoCut:     return canMove<CornerRule::NoCut>(walls, dir);
+        case CornerRule::NoSqueeze: return canMove<CornerRule::NoSqueeze>(walls, dir);
+        case CornerRule::Cut:
+        default:                    return canMove<CornerRule::Cut>(walls, dir);
+    }
+}
+
+// A* distance estimate. Auto picks the tightest admissible one for the
+// neighborhood: Manhattan when 4-connected, octile when 8-connected.
+enum class HeuristicKind : int
+{
+    Auto = 0,
+    Manhattan = 1,  // overestimates with diagonal moves: faster, not optimal
+    Octile = 2,     // exact on an open 8-connected grid
+    Chebyshev = 3,  // admissible, looser than octile
+    Euclidean = 4,  // admissible, looser than octile
+    Landmarks = 5   // ALT: max of Auto and landmark bounds (LandmarkTable)
+};
+
+// Distance estimates for a cell offset (|dr|, |dc|), in cost units
+inline std::uint32_t manhattanCost(int dr, int dc) { return cOrthCost * std::uint32_t(dr + dc); }
+inline std::uint32_t chebyshevCost(int dr, int dc) { return cOrthCost * std::uint32_t(std::max(dr, dc)); }
+inline std::uint32_t octileCost(int dr, int dc)
+{
+    const int lo = std::min(dr, dc), hi = std::max(dr, dc);
+    return cOrthCost * std::uint32_t(hi - lo) + cDiagCost * std::uint32_t(lo);
+}
+// Scaled by cDiagCost / sqrt 2 (9.9) rather than cOrthCost, so that a
+// diagonal run, which costs 14 and not 14.14 per step, is not overestimated
+inline std::uint32_t euclideanCost(int dr, int dc)
+{
+    return std::uint32_t(std::sqrt(double(dr) * dr + double(dc) * dc) * (cDiagCost / std::sqrt(2.0)));
+}
+
+// Algorithms that search with the heuristic in the options
+inline bool usesHeuristic(Algorithm a)
+{
+    return a == Algorithm::AStar || a == Algorithm::JPS || a == Algorithm::BidirectionalAStar;
+}
+
+inline HeuristicKind resolveHeuristic(HeuristicKind h, bool diagonal)
+{
+    if (h != HeuristicKind::Auto) return h;
+    return diagonal ? HeuristicKind::Octile : HeuristicKind::Manhattan;
+}
+
+// True if the algorithm always returns a least-cost path for these options,
+// so any other least-cost path is an equally good answer for it
+inline bool findsLeastCost(Algorithm a, HeuristicKind h, bool diagonal)
+{
+    switch (a)
+    {
+        case Algorithm::BFS:
+        case Algorithm::BidirectionalBFS:   return !diagonal;    // counts moves, not cost
+        case Algorithm::HPAStar:            return false;
+        case Algorithm::AStar:
+        case Algorithm::JPS:
+        case Algorithm::BidirectionalAStar: return !(diagonal && resolveHeuristic(h, diagonal) == HeuristicKind::Manhattan);
+        default:                            return true;
+    }
+}
+
+// Stop request for the long table builds and searches a worker runs
+// (nullptr = none); they check it every few thousand cells and give up
+using CancelFlag = const std::atomic<bool>*;
+
+inline bool cancelled(CancelFlag cancel) { return cancel && cancel->load(std::memory_order_relaxed); }
+
+// v.assign(n, value) a million entries at a time, checking cancel in
+// between (first touching the pages of a huge per-cell array is slow);
+// false, with v cleared, if cancelled
+template <class T>
+inline bool assignCancellable(std::vector<T>& v, std::size_t n, const T& value, CancelFlag cancel)
+{
+    constexpr std::size_t cSlice = std::size_t(1) << 20;
+    v.clear();
+    v.reserve(n);
+    for (std::size_t i = 0; i < n; i += cSlice)
+    {
+        if (cancelled(cancel))
+        {
+            v.clear();
+            return false;
+        }
+        v.insert(v.end(), std::min(cSlice, n - i), value);
+    }
+    return true;
+}
+
+// Per-cell search visualization state
+enum class CellState : std::uint8_t
+{
+    None = 0,
+    Visited = 1,    // closed
+    Frontier = 2,   // open
+    Path = 3
+};
+
+inline const char* algorithmName(Algorithm a)
+{
+    switch (a)
+    {
+        case Algorithm::BFS:      return "BFS";
+        case Algorithm::Dijkstra: return "Dijkstra";
+        case Algorithm::AStar:    return "A*";
+        case Algorithm::JPS:      return "JPS";
+        case Algorithm::BidirectionalBFS:   return "Bi-BFS";
+        case Algorithm::BidirectionalAStar: return "Bi-A*";
+        case Algorithm::DStarLite:          return "D* Lite";
+        case Algorithm::HPAStar:            return "HPA*";
+    }
+    return "?";
+}
+
+inline const char* heuristicName(HeuristicKind h)
+{
+    switch (h)
+    {
+        case HeuristicKind::Auto:      return "auto";
+        case HeuristicKind::Manhattan: return "manhattan";
+        case HeuristicKind::Octile:    return "octile";
+        case HeuristicKind::Chebyshev: return "chebyshev";
+        case HeuristicKind::Euclidean: return "euclidean";
+        case HeuristicKind::Landmarks: return "alt";
+    }
+    return "?";
+}
+
+inline const char* cornerRuleName(CornerRule r)
+{
+    switch (r)
+    {
+        case CornerRule::Cut:       return "cut";
+        case CornerRule::NoSqueeze: return "nosqueeze";
+        case CornerRule::NoCut:     return "nocut";
+    }
+    return "?";
+}
+
+} // namespace maze
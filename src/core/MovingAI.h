@@ -0,0 +1,144 @@
+#pragma once
+#include <istream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Grid.h"
+#include "BitGrid.h"
+
+namespace maze
+{
+
+// MovingAI benchmark formats (movingai.com/benchmarks).
+//
+// .map: a short header, then one line of `width` characters per row
+//   type octile
+//   height H
+//   width W
+//   map
+//   '.' 'G' 'S' free (ground, swamp); '@' 'O' 'T' 'W' walls (out of
+//   bounds, trees, water)
+//
+// .scen: "version 1", then one query per line:
+//   bucket  map  mapWidth  mapHeight  startX  startY  goalX  goalY  optimalLength
+// x is the column and y the row. optimalLength is the octile cost (1 per
+// orthogonal move, sqrt(2) per diagonal one) without corner cutting, the
+// movement of --diagonal --corners nocut.
+//
+// Both are read line by line into one reused buffer, never slurped whole.
+
+struct ScenarioQuery
+{
+    int bucket = 0;
+    Cell start;
+    Cell goal;
+    int mapWidth = 0;
+    int mapHeight = 0;
+    double optimal = 0;         // reference octile cost
+};
+
+// True if the file starts like a MovingAI map ("type ...")
+inline bool isMovingAIMap(const std::string& path)
+{
+    std::ifstream in(path);
+    std::string line;
+    return std::getline(in, line) && line.compare(0, 5, "type ") == 0;
+}
+
+// Reads a .map into grid. The format has no start or goal, so they are set
+// to the first and the last free cell. False, with grid unchanged, if the
+// header or a row is malformed.
+inline bool readMovingAIMap(std::istream& in, Grid& grid)
+{
+    std::string line, key;
+    int height = 0, width = 0;
+    for (;;)
+    {
+        if (!std::getline(in, line))
+            return false;
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line == "map")
+            break;
+        std::istringstream fields(line);
+        fields >> key;
+        if (key == "height") fields >> height;
+        else if (key == "width") fields >> width;
+        // "type" is "octile" in every published map; unknown keys are skipped
+    }
+    if (height < Grid::cMinDim || width < Grid::cMinDim || height > Grid::cMaxDim || width > Grid::cMaxDim)
+        return false;
+
+    BitGrid walls;
+    walls.resize(height, width);
+    for (int r = 0; r < height; r++)
+    {
+        if (!std::getline(in, line))
+            return false;
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (int(line.size()) != width)
+            return false;
+        for (int c = 0; c < width; c++)
+        {
+            switch (line[c])
+            {
+                case '.': case 'G': case 'S': break;
+                case '@': case 'O': case 'T': case 'W': walls.set(r, c, true); break;
+                default: return false;
+            }
+        }
+    }
+    grid.assignWalls(std::move(walls));
+
+    const std::size_t n = grid.size();
+    std::size_t first = 0, last = n;
+    while (first < n && grid.isWall(first)) first++;
+    while (last > first && grid.isWall(last - 1)) last--;
+    if (first < n)
+    {
+        grid.setStart(grid.cellAt(first));
+        grid.setGoal(grid.cellAt(last - 1));
+    }
+    return true;
+}
+
+// Reads the queries of a .scen file; mapName receives the map of the first
+// one. False if a line is malformed or there are no queries.
+inline bool readMovingAIScenario(std::istream& in, std::vector<ScenarioQuery>& queries, std::string* mapName = nullptr)
+{
+    queries.clear();
+    std::string line, map;
+    while (std::getline(in, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line.empty() || line.compare(0, 7, "version") == 0)
+            continue;
+        std::istringstream fields(line);
+        ScenarioQuery q;
+        if (!(fields >> q.bucket >> map >> q.mapWidth >> q.mapHeight >> q.start.c >> q.start.r >> q.goal.c >> q.goal.r >> q.optimal))
+            return false;
+        if (mapName && queries.empty())
+            *mapName = map;
+        queries.push_back(q);
+    }
+    return !queries.empty();
+}
+
+// Octile cost of a path as the scenario files measure it (diagonal moves
+// cost sqrt(2), not the engine's 1.4)
+inline double octileLength(const std::vector<Cell>& path)
+{
+    double length = 0;
+    for (std::size_t k = 1; k < path.size(); k++)
+    {
+        const bool diagonal = path[k].r != path[k - 1].r && path[k].c != path[k - 1].c;
+        length += diagonal ? 1.4142135623730951 : 1.0;
+    }
+    return length;
+}
+
+} // namespace maze
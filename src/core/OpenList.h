@@ -0,0 +1,381 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "MazeTypes.h"
+
+namespace maze
+{
+
+// Open-list backends for Dijkstra/A*. All share one interface:
+//   clear(), empty(), size(), push(idx, f, g), top(), pop() -> OpenNode
+// Ties on f are broken toward higher g (deeper nodes first).
+//
+// BinaryHeap, QuaternaryHeap and BucketQueue use lazy deletion: an improved
+// cell is pushed again and the caller skips stale pops. PairingHeap supports
+// decrease-key, so push() on a queued cell updates it in place and pops are
+// never stale.
+
+enum class OpenListKind : int
+{
+    BinaryHeap = 0,
+    QuaternaryHeap = 1,
+    PairingHeap = 2,
+    BucketQueue = 3
+};
+
+inline const char* openListName(OpenListKind k)
+{
+    switch (k)
+    {
+        case OpenListKind::BinaryHeap:     return "heap2";
+        case OpenListKind::QuaternaryHeap: return "heap4";
+        case OpenListKind::PairingHeap:    return "pairing";
+        case OpenListKind::BucketQueue:    return "bucket";
+    }
+    return "?";
+}
+
+struct OpenNode { std::uint32_t f,g; CellIndex idx; };
+
+// a before b?
+inline bool openBefore(const OpenNode& a, const OpenNode& b)
+{
+    return a.f < b.f || (a.f == b.f && a.g > b.g);
+}
+
+// ----- std heap on a vector -----
+class BinaryHeap
+{
+    struct After { bool operator()(const OpenNode& a, const OpenNode& b) const { return openBefore(b, a); } };
+    std::vector<OpenNode> _heap;
+
+public:
+    static constexpr bool cDecreaseKey = false;
+
+    void clear() { _heap.clear(); }
+    bool empty() const { return _heap.empty(); }
+    std::size_t size() const { return _heap.size(); }
+
+    void push(CellIndex idx, std::uint32_t f, std::uint32_t g)
+    {
+        _heap.push_back({f, g, idx});
+        std::push_heap(_heap.begin(), _heap.end(), After());
+    }
+
+    const OpenNode& top() const { return _heap.front(); }
+
+    OpenNode pop()
+    {
+        std::pop_heap(_heap.begin(), _heap.end(), After());
+        OpenNode n = _heap.back();
+        _heap.pop_back();
+        return n;
+    }
+};
+
+// ----- 4-ary implicit heap: shallower tree, children share a cache line -----
+class QuaternaryHeap
+{
+    std::vector<OpenNode> _heap;
+
+    void siftUp(std::size_t i)
+    {
+        OpenNode n = _heap[i];
+        while (i > 0)
+        {
+            std::size_t p = (i - 1) >> 2;
+            if (!openBefore(n, _heap[p])) break;
+            _heap[i] = _heap[p];
+            i = p;
+        }
+        _heap[i] = n;
+    }
+
+    void siftDown(std::size_t i)
+    {
+        const std::size_t n = _heap.size();
+        OpenNode x = _heap[i];
+        for (;;)
+        {
+            std::size_t first = (i << 2) + 1;
+            if (first >= n) break;
+            std::size_t last = std::min(first + 4, n);
+            std::size_t best = first;
+            for (std::size_t k = first + 1; k < last; k++)
+                if (openBefore(_heap[k], _heap[best])) best = k;
+            if (!openBefore(_heap[best], x)) break;
+            _heap[i] = _heap[best];
+            i = best;
+        }
+        _heap[i] = x;
+    }
+
+public:
+    static constexpr bool cDecreaseKey = false;
+
+    void clear() { _heap.clear(); }
+    bool empty() const { return _heap.empty(); }
+    std::size_t size() const { return _heap.size(); }
+
+    void push(CellIndex idx, std::uint32_t f, std::uint32_t g)
+    {
+        _heap.push_back({f, g, idx});
+        siftUp(_heap.size() - 1);
+    }
+
+    const OpenNode& top() const { return _heap.front(); }
+
+    OpenNode pop()
+    {
+        OpenNode top = _heap.front();
+        _heap.front() = _heap.back();
+        _heap.pop_back();
+        if (!_heap.empty())
+            siftDown(0);
+        return top;
+    }
+};
+
+// ----- pairing heap with decrease-key (nodes live in a pool, linked by index) -----
+class PairingHeap
+{
+    static constexpr std::uint32_t cNil = ~std::uint32_t(0);
+
+    struct Node
+    {
+        OpenNode key;
+        std::uint32_t child = cNil;
+        std::uint32_t sibling = cNil;
+        std::uint32_t prev = cNil;     // parent if first child, else left sibling
+    };
+
+    std::vector<Node> _pool;
+    std::vector<std::uint32_t> _handle;   // cell -> pool node while queued (allocated on first push)
+    std::size_t _cells = 0;
+    std::vector<std::uint32_t> _pairs;    // scratch for pop
+    std::uint32_t _root = cNil;
+    std::size_t _size = 0;
+
+    std::uint32_t meld(std::uint32_t a, std::uint32_t b)
+    {
+        if (a == cNil) return b;
+        if (b == cNil) return a;
+        if (openBefore(_pool[b].key, _pool[a].key)) std::swap(a, b);
+        // b becomes first child of a
+        Node& na = _pool[a];
+        Node& nb = _pool[b];
+        nb.sibling = na.child;
+        if (na.child != cNil) _pool[na.child].prev = b;
+        nb.prev = a;
+        na.child = b;
+        na.sibling = cNil;
+        na.prev = cNil;
+        return a;
+    }
+
+    void detach(std::uint32_t x)
+    {
+        Node& n = _pool[x];
+        if (_pool[n.prev].child == x) _pool[n.prev].child = n.sibling;
+        else _pool[n.prev].sibling = n.sibling;
+        if (n.sibling != cNil) _pool[n.sibling].prev = n.prev;
+        n.sibling = cNil;
+        n.prev = cNil;
+    }
+
+public:
+    static constexpr bool cDecreaseKey = true;
+
+    // Sets the size of the cell -> node map; call when the grid size changes.
+    // The map itself is allocated only once this backend is actually used.
+    void resizeCells(std::size_t n)
+    {
+        _cells = n;
+        _handle.clear();
+        _handle.shrink_to_fit();
+        _pool.clear();
+        _root = cNil;
+        _size = 0;
+    }
+
+    void clear()
+    {
+        // only cells that were ever pushed have a handle set
+        for (const auto& n : _pool)
+            _handle[n.key.idx] = cNil;
+        _pool.clear();
+        _root = cNil;
+        _size = 0;
+    }
+
+    bool empty() const { return _size == 0; }
+    std::size_t size() const { return _size; }
+
+    const OpenNode& top() const { return _pool[_root].key; }
+
+    // Inserts idx, or lowers its key if it is already queued
+    void push(CellIndex idx, std::uint32_t f, std::uint32_t g)
+    {
+        if (_handle.empty())
+            _handle.assign(_cells, cNil);
+        std::uint32_t h = _handle[idx];
+        if (h != cNil)
+        {
+            _pool[h].key.f = f;
+            _pool[h].key.g = g;
+            if (h != _root)
+            {
+                detach(h);
+                _root = meld(_root, h);
+            }
+            return;
+        }
+        std::uint32_t x = std::uint32_t(_pool.size());
+        _pool.push_back(Node{{f, g, idx}});
+        _handle[idx] = x;
+        _root = meld(_root, x);
+        ++_size;
+    }
+
+    OpenNode pop()
+    {
+        std::uint32_t top = _root;
+        OpenNode key = _pool[top].key;
+        _handle[key.idx] = cNil;
+        --_size;
+
+        // two-pass pairing of the root's children
+        _pairs.clear();
+        std::uint32_t c = _pool[top].child;
+        while (c != cNil)
+        {
+            std::uint32_t a = c;
+            std::uint32_t b = _pool[a].sibling;
+            c = (b != cNil) ? _pool[b].sibling : cNil;
+            _pool[a].sibling = _pool[a].prev = cNil;
+            if (b != cNil) _pool[b].sibling = _pool[b].prev = cNil;
+            _pairs.push_back(meld(a, b));
+        }
+        std::uint32_t r = cNil;
+        for (std::size_t i = _pairs.size(); i-- > 0;)
+            r = meld(r, _pairs[i]);
+        _root = r;
+        return key;
+    }
+};
+
+// ----- Dial bucket queue for small integer edge costs -----
+// A ring of f-buckets covers [curF, curF + ring size). With a consistent
+// heuristic all queued f values lie within a few edge costs of the minimum,
+// so the ring stays tiny; it grows if a wider span ever shows up.
+// Inside a bucket, entries are sorted by h = f - g, highest first, and
+// popped from the back: the lowest h (highest g) first, the latest of equal
+// ones first. Most pushes have the lowest h so far and are appended; the
+// others are inserted by binary search. A bucket takes memory for its
+// entries only, whatever the range of h.
+class BucketQueue
+{
+    struct Bucket
+    {
+        std::vector<std::uint64_t> byH;     // h << 32 | cell
+    };
+
+    std::vector<Bucket> _ring;
+    std::size_t _mask = 0;
+    std::uint32_t _curF = 0;
+    std::uint32_t _maxF = 0;
+    std::size_t _size = 0;
+
+    static std::uint32_t hOf(std::uint64_t e) { return std::uint32_t(e >> 32); }
+
+    void grow(std::size_t span)
+    {
+        std::size_t n = std::max<std::size_t>(_ring.size(), 8);
+        while (n < span) n <<= 1;
+        std::vector<Bucket> ring(n);
+        if (_size > 0)
+        {
+            for (std::uint32_t f = _curF; f <= _maxF; f++)
+                ring[f & (n - 1)] = std::move(_ring[f & _mask]);
+        }
+        _ring.swap(ring);
+        _mask = n - 1;
+    }
+
+    // Advances the cursor to the lowest non-empty bucket
+    Bucket& firstBucket()
+    {
+        while (_ring[_curF & _mask].byH.empty())
+            ++_curF;
+        return _ring[_curF & _mask];
+    }
+
+    OpenNode nodeOf(std::uint64_t e) const
+    {
+        return OpenNode{_curF, _curF - hOf(e), CellIndex(std::uint32_t(e))};
+    }
+
+public:
+    static constexpr bool cDecreaseKey = false;
+
+    BucketQueue() { grow(8); }
+
+    void clear()
+    {
+        if (_size > 0)
+        {
+            for (auto& b : _ring)
+                b.byH.clear();
+        }
+        _size = 0;
+    }
+
+    bool empty() const { return _size == 0; }
+    std::size_t size() const { return _size; }
+
+    void push(CellIndex idx, std::uint32_t f, std::uint32_t g)
+    {
+        if (_size == 0)
+        {
+            _curF = _maxF = f;
+        }
+        else
+        {
+            std::uint32_t lo = std::min(_curF, f);
+            std::uint32_t hi = std::max(_maxF, f);
+            if (std::size_t(hi - lo) >= _ring.size())
+                grow(std::size_t(hi - lo) + 1);
+            _curF = lo;
+            _maxF = hi;
+        }
+
+        auto& byH = _ring[f & _mask].byH;
+        const std::uint32_t h = f - g;
+        const std::uint64_t e = std::uint64_t(h) << 32 | std::uint32_t(idx);
+        if (byH.empty() || hOf(byH.back()) >= h)
+            byH.push_back(e);
+        else
+            byH.insert(std::upper_bound(byH.begin(), byH.end(), e,
+                                        [](std::uint64_t a, std::uint64_t b) { return hOf(a) > hOf(b); }), e);
+        ++_size;
+    }
+
+    OpenNode top()
+    {
+        return nodeOf(firstBucket().byH.back());
+    }
+
+    OpenNode pop()
+    {
+        auto& byH = firstBucket().byH;
+        const OpenNode n = nodeOf(byH.back());
+        byH.pop_back();
+        --_size;
+        return n;
+    }
+};
+
+} // namespace maze
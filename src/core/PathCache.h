@@ -0,0 +1,422 @@
+#pragma once
+#include <list>
+#include <vector>
+#include <mutex>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+#include "Grid.h"
+#include "MazeTypes.h"
+#include "CostSweep.h"
+
+namespace maze
+{
+
+// What a query is answered under, apart from the grid it runs on
+struct PathKey
+{
+    Cell start;
+    Cell goal;
+    Algorithm algorithm = Algorithm::AStar;
+    HeuristicKind heuristic = HeuristicKind::Auto;
+    bool diagonal = false;
+    CornerRule corners = CornerRule::Cut;
+    int clusterSize = 0;        // HPA* answers depend on it
+
+    bool operator==(const PathKey& o) const
+    {
+        return start == o.start && goal == o.goal && algorithm == o.algorithm && heuristic == o.heuristic &&
+               diagonal == o.diagonal && corners == o.corners && clusterSize == o.clusterSize;
+    }
+};
+
+struct PathKeyHash
+{
+    std::size_t operator()(const PathKey& k) const
+    {
+        std::uint64_t h = (std::uint64_t(std::uint32_t(k.start.r)) << 32) | std::uint32_t(k.start.c);
+        h = h * 0x9E3779B97F4A7C15ull ^ ((std::uint64_t(std::uint32_t(k.goal.r)) << 32) | std::uint32_t(k.goal.c));
+        h = h * 0x9E3779B97F4A7C15ull ^ (std::uint64_t(k.algorithm) | std::uint64_t(k.heuristic) << 8 |
+                                         std::uint64_t(k.diagonal) << 16 | std::uint64_t(k.corners) << 24 |
+                                         std::uint64_t(std::uint32_t(k.clusterSize)) << 32);
+        return std::size_t(h ^ (h >> 29));
+    }
+};
+
+struct CachedPath
+{
+    bool solved = false;
+    std::uint32_t cost = 0;
+    std::vector<Cell> path;     // start .. goal
+};
+
+// Least-cost tree rooted at a goal: every reached cell knows its move
+// towards the goal, so the path from any start is a walk along it.
+class GoalTree
+{
+    Cell _goal;
+    bool _diagonal = false;
+    CornerRule _corners = CornerRule::Cut;
+    int _cols = 0;
+    std::vector<std::int8_t> _toParent;     // move that reached the cell from the goal side
+
+public:
+    void build(const Grid& grid, Cell goal, bool diagonal, CornerRule corners, CostSweep& sweep)
+    {
+        _goal = goal;
+        _diagonal = diagonal;
+        _corners = corners;
+        _cols = grid.cols();
+        sweep.run(grid, goal, diagonal, corners, &_toParent);
+    }
+
+    bool serves(Cell goal, bool diagonal, CornerRule corners) const
+    {
+        return _goal == goal && _diagonal == diagonal && (!diagonal || _corners == corners);
+    }
+
+    // Fills out with the path from start; unsolved if the goal is not reachable
+    void walk(Cell start, CachedPath& out) const
+    {
+        out.path.clear();
+        out.cost = 0;
+        out.solved = false;
+        Cell cell = start;
+        std::size_t i = std::size_t(cell.r) * std::size_t(_cols) + std::size_t(cell.c);
+        if (cell != _goal && _toParent[i] == CostSweep::cNoDir)
+            return;
+        out.path.push_back(cell);
+        while (cell != _goal)
+        {
+            // moves are symmetric: step back along the move that reached the cell
+            const int dir = _toParent[i];
+            cell.r -= cDirR[dir];
+            cell.c -= cDirC[dir];
+            i = std::size_t(cell.r) * std::size_t(_cols) + std::size_t(cell.c);
+            out.cost += stepCost(dir);
+            out.path.push_back(cell);
+        }
+        out.solved = true;
+    }
+
+    std::size_t bytes() const { return _toParent.capacity(); }
+};
+
+// LRU cache of solved queries for one grid at a time. Entries are keyed by
+// the endpoints and the options that shape the answer (PathKey); the grid
+// is identified by Grid::generation(), unique per process and change, so any
+// wall edit, regeneration or resize empties the cache on the next access,
+// and another grid that reuses the address of a destroyed one is not
+// mistaken for it.
+//
+// Goals that keep missing with different starts get a GoalTree (one
+// Dijkstra sweep from the goal), after which every start is answered by a
+// walk along the tree. Trees take a byte per cell, so few fit the budget on
+// a large grid. When it is full, a goal's tree replaces the least used one
+// only once the goal has missed more often than that tree has been used;
+// every refusal ages the tree by one use, so trees of goals nobody asks for
+// any more make room. Tree answers are least-cost paths, so they are only
+// given to callers whose algorithm finds least-cost paths too (the exact
+// flag; see findsLeastCost()); the path may differ from the one that
+// algorithm would have picked, its cost does not.
+//
+// All members are safe to call from several threads; trees are built
+// outside the lock. The grid must not change while a lookup builds a tree.
+class PathCache
+{
+public:
+    static constexpr std::size_t cDefaultCapacity = 4096;
+    static constexpr std::size_t cDefaultTreeBytes = std::size_t(64) << 20;   // one byte per cell and tree
+    static constexpr unsigned cDefaultTreeAfter = 2;
+
+    struct Stats
+    {
+        std::uint64_t hits = 0;         // answered from an entry
+        std::uint64_t treeHits = 0;     // answered by walking a goal tree
+        std::uint64_t misses = 0;
+        std::uint64_t treesBuilt = 0;
+        std::uint64_t invalidations = 0;    // emptied because the grid changed
+
+        std::uint64_t lookups() const { return hits + treeHits + misses; }
+        double hitRate() const { return lookups() ? double(hits + treeHits) / double(lookups()) : 0.0; }
+    };
+
+private:
+    struct Entry
+    {
+        PathKey key;
+        CachedPath result;
+    };
+
+    // Misses per goal and movement model, to decide when a tree pays off
+    struct GoalKey
+    {
+        Cell goal;
+        bool diagonal;
+        CornerRule corners;
+        bool operator==(const GoalKey& o) const { return goal == o.goal && diagonal == o.diagonal && corners == o.corners; }
+    };
+    struct GoalKeyHash
+    {
+        std::size_t operator()(const GoalKey& k) const
+        {
+            return PathKeyHash()(PathKey{k.goal, k.goal, Algorithm::BFS, HeuristicKind::Auto, k.diagonal, k.corners, 0});
+        }
+    };
+    struct GoalMisses
+    {
+        unsigned misses = 0;
+        bool building = false;
+    };
+
+    mutable std::mutex _mutex;
+    std::size_t _capacity;
+    unsigned _treeAfter = cDefaultTreeAfter;
+    std::size_t _treeBytes = cDefaultTreeBytes;
+    std::uint64_t _generation = 0;          // 0: no grid seen yet
+
+    std::list<Entry> _lru;                  // most recent first
+    std::unordered_map<PathKey, std::list<Entry>::iterator, PathKeyHash> _index;
+    struct TreeSlot
+    {
+        GoalTree tree;
+        std::uint64_t uses;
+    };
+    std::vector<TreeSlot> _trees;
+    std::unordered_map<GoalKey, GoalMisses, GoalKeyHash> _goalMisses;
+    Stats _stats;
+
+    bool current(const Grid& grid) const
+    {
+        return _generation == grid.generation();
+    }
+
+    // Empties the cache if it describes other walls
+    void sync(const Grid& grid)
+    {
+        if (current(grid))
+            return;
+        if (_generation != 0 && (!_lru.empty() || !_trees.empty()))
+            _stats.invalidations++;
+        _generation = grid.generation();
+        dropAll();
+    }
+
+    void dropAll()
+    {
+        _lru.clear();
+        _index.clear();
+        _trees.clear();
+        _goalMisses.clear();
+    }
+
+    TreeSlot* findTree(const GoalKey& g)
+    {
+        for (TreeSlot& slot : _trees)
+            if (slot.tree.serves(g.goal, g.diagonal, g.corners))
+                return &slot;
+        return nullptr;
+    }
+
+    std::size_t leastUsedTree() const
+    {
+        std::size_t victim = 0;
+        for (std::size_t i = 1; i < _trees.size(); i++)
+            if (_trees[i].uses < _trees[victim].uses)
+                victim = i;
+        return victim;
+    }
+
+    // True if one more tree of treeBytes fits the budget (one always does)
+    bool treeFits(std::size_t treeBytes) const
+    {
+        return _trees.empty() || (_trees.size() + 1) * treeBytes <= _treeBytes;
+    }
+
+    void insert(const PathKey& key, const CachedPath& result)
+    {
+        if (_capacity == 0)
+            return;
+        auto found = _index.find(key);
+        if (found != _index.end())
+        {
+            found->second->result = result;
+            _lru.splice(_lru.begin(), _lru, found->second);
+            return;
+        }
+        if (_lru.size() >= _capacity)
+        {
+            _index.erase(_lru.back().key);
+            _lru.pop_back();
+        }
+        _lru.push_front(Entry{key, result});
+        _index.emplace(key, _lru.begin());
+    }
+
+    // Answers from the goal's tree, building it first if the goal has
+    // missed often enough. Called and returns with the lock held.
+    bool fromTree(const Grid& grid, const PathKey& key, std::unique_lock<std::mutex>& lock, CachedPath& out)
+    {
+        const GoalKey g{key.goal, key.diagonal, key.diagonal ? key.corners : CornerRule::Cut};
+        if (TreeSlot* slot = findTree(g))
+        {
+            slot->uses++;
+            slot->tree.walk(key.start, out);
+            return true;
+        }
+        if (_treeAfter == 0)
+            return false;
+        GoalMisses& m = _goalMisses[g];
+        if (m.building || ++m.misses < _treeAfter)
+            return false;
+        if (!treeFits(grid.size()))
+        {
+            TreeSlot& victim = _trees[leastUsedTree()];
+            if (victim.uses >= m.misses)
+            {
+                victim.uses--;
+                return false;
+            }
+        }
+
+        const std::uint64_t misses = m.misses;
+        m.building = true;
+        const std::uint64_t generation = _generation;
+        lock.unlock();
+        GoalTree tree;
+        CostSweep sweep;
+        tree.build(grid, key.goal, key.diagonal, key.corners, sweep);
+        lock.lock();
+
+        if (_generation != generation || !current(grid))
+            return false;   // emptied meanwhile: the tree may describe old walls
+        _goalMisses.erase(g);
+        while (!treeFits(tree.bytes()))
+            _trees.erase(_trees.begin() + std::ptrdiff_t(leastUsedTree()));
+        // the misses that earned the tree count as its first uses
+        _trees.push_back(TreeSlot{std::move(tree), misses});
+        _stats.treesBuilt++;
+        _trees.back().tree.walk(key.start, out);
+        return true;
+    }
+
+public:
+    explicit PathCache(std::size_t capacity = cDefaultCapacity)
+        : _capacity(capacity)
+    {
+    }
+
+    // Looks the query up on grid. Returns true with out filled on a hit.
+    // exact: the caller's algorithm finds least-cost paths, so a goal tree
+    // may answer for it.
+    bool lookup(const Grid& grid, const PathKey& key, bool exact, CachedPath& out)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        sync(grid);
+        auto found = _index.find(key);
+        if (found != _index.end())
+        {
+            _lru.splice(_lru.begin(), _lru, found->second);
+            const CachedPath& hit = found->second->result;
+            out.solved = hit.solved;
+            out.cost = hit.cost;
+            out.path.assign(hit.path.begin(), hit.path.end());
+            _stats.hits++;
+            return true;
+        }
+        if (exact && fromTree(grid, key, lock, out))
+        {
+            insert(key, out);
+            _stats.treeHits++;
+            return true;
+        }
+        _stats.misses++;
+        return false;
+    }
+
+    // Remembers the answer the caller found after a miss
+    void store(const Grid& grid, const PathKey& key, const CachedPath& result)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        sync(grid);
+        insert(key, result);
+    }
+
+    // Drops every entry and tree (statistics are kept)
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        dropAll();
+    }
+
+    // Entries kept at most; 0 disables the entries (goal trees still answer)
+    void setCapacity(std::size_t capacity)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _capacity = capacity;
+        while (_lru.size() > _capacity)
+        {
+            _index.erase(_lru.back().key);
+            _lru.pop_back();
+        }
+    }
+
+    std::size_t capacity() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _capacity;
+    }
+
+    // Misses on one goal, from different starts, before its tree is built; 0 = never
+    void setTreeAfter(unsigned misses)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _treeAfter = misses;
+    }
+
+    // Memory the goal trees may use together (at least one is kept)
+    void setTreeBytes(std::size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _treeBytes = bytes;
+    }
+
+    Stats stats() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _stats;
+    }
+
+    void resetStats()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stats = Stats();
+    }
+
+    std::size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _lru.size();
+    }
+
+    std::size_t treeCount() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _trees.size();
+    }
+
+    // Approximate heap use of entries and trees
+    std::size_t bytes() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::size_t b = 0;
+        for (const Entry& e : _lru)
+            b += sizeof(Entry) + e.result.path.capacity() * sizeof(Cell) + 4 * sizeof(void*);
+        for (const TreeSlot& t : _trees)
+            b += t.tree.bytes();
+        return b;
+    }
+};
+
+} // namespace maze
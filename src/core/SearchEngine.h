@@ -0,0 +1,1240 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <utility>
+#include <limits>
+#include <algorithm>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+
+#include "Grid.h"
+#include "OpenList.h"
+#include "JumpPoint.h"
+#include "SearchScratch.h"
+#include "SearchTrace.h"
+#include "DStarLite.h"
+#include "Hierarchy.h"
+#include "Landmarks.h"
+#include "Connectivity.h"
+#include "PathCache.h"
+
+namespace maze
+{
+
+// Snapshot of the live search counters; every field is O(1) to read
+struct SearchStats
+{
+    std::size_t visited = 0;        // closed cells (both sides for bidirectional searches)
+    std::size_t frontier = 0;       // cells currently marked as frontier
+    std::size_t openSize = 0;       // entries in the open list(s) / queue(s), stale ones included
+    std::size_t peakOpen = 0;       // largest openSize seen during the search
+    std::uint64_t expansions = 0;
+    std::uint64_t pushes = 0;
+    std::uint64_t stalePops = 0;
+    std::size_t pathLength = 0;     // cells on the path, 0 until solved
+    long long pathCost = -1;        // -1 until solved
+};
+
+// Step-by-step BFS / Dijkstra / A* / JPS and bidirectional BFS / A* over a
+// Grid. The grid is only read; the engine keeps its own per-cell scratch
+// (state, g, parent).
+//
+// Walls are read from the bit-packed grid: one 3x3 wall mask per expansion
+// replaces the per-neighbor bounds check and byte load; the same mask tells
+// whether a diagonal move passes a wall corner (Options::corners). The step
+// functions are templates on the neighborhood, heuristic and open list; the
+// options select one instantiation per step() or per run() (see withKernel).
+//
+// Per-cell scratch is generation-stamped (see SearchScratch), so begin() and
+// clear() are O(1) and a search costs in proportion to the area it explores,
+// not the map size. Parents are stored as the direction of the move that
+// reached the cell instead of a full index. Bidirectional searches add a
+// second scratch array for the backward side, allocated on first use.
+//
+// Optionally every run is recorded into a SearchTrace (one record per step,
+// taken from the change log), so it can be replayed without searching again.
+class SearchEngine
+{
+public:
+    struct Options
+    {
+        Algorithm algorithm = Algorithm::AStar;
+        bool diagonal = false;
+        CornerRule corners = CornerRule::Cut;               // diagonal moves past walls
+        HeuristicKind heuristic = HeuristicKind::Auto;      // A*, JPS, Bi-A*
+        OpenListKind openList = OpenListKind::BinaryHeap;   // all but BFS
+        bool jumpTable = false;                             // JPS+: precomputed jump distances
+        int clusterSize = PathHierarchy::cDefaultClusterSize; // HPA*: cluster edge in cells
+        int landmarks = LandmarkTable::cDefaultCount;       // ALT heuristic: landmark count
+    };
+
+private:
+    static constexpr std::uint32_t cInf = SearchScratch::cInf;
+
+    enum Side : int { Forward = 0, Backward = 1 };
+
+    // One instance of every backend; a search uses the one selected in Options
+    struct OpenLists
+    {
+        BinaryHeap heap2;
+        QuaternaryHeap heap4;
+        PairingHeap pairing;
+        BucketQueue buckets;
+
+        void resizeCells(std::size_t n) { pairing.resizeCells(n); }
+        void clear()
+        {
+            heap2.clear();
+            heap4.clear();
+            pairing.clear();
+            buckets.clear();
+        }
+    };
+
+    // FIFO over a vector: clear() keeps the storage and costs O(1)
+    struct Fifo
+    {
+        std::vector<CellIndex> items;
+        std::size_t head = 0;
+
+        bool empty() const { return head == items.size(); }
+        std::size_t size() const { return items.size() - head; }
+        CellIndex front() const { return items[head]; }
+        void push(CellIndex i) { items.push_back(i); }
+        void pop() { ++head; }
+        void clear() { items.clear(); head = 0; }
+    };
+
+    const Grid* _grid = nullptr;
+    Options _opt;
+    Cell _start;                            // endpoints of the current search
+    Cell _goal;
+
+    std::size_t _cells = 0;
+    SearchScratch _scr[2];                  // forward, backward (bidirectional only)
+    std::vector<Cell> _path;
+
+    bool _running = false;
+    bool _finished = false;
+    bool _solved = false;
+    std::uint32_t _pathCost = 0;
+    std::uint64_t _expansions = 0;
+    std::uint64_t _pushes = 0;
+    std::uint64_t _stalePops = 0;
+    std::size_t _peakOpen = 0;
+
+    OpenLists _open[2];
+    Fifo _q[2];
+    JumpPoints _jps;
+    DStarLite _dstar;                       // kept between searches for replanning
+    std::shared_ptr<PathHierarchy> _hierarchy;  // HPA* graph, kept between searches
+    HierarchySearch _hpa;
+    std::shared_ptr<LandmarkTable> _landmarks;  // ALT tables, kept between searches
+    const ConnectivityIndex* _components = nullptr;
+    PathCache* _cache = nullptr;            // not owned; consulted by run()
+    CancelFlag _cancel = nullptr;           // not owned; see setCancelFlag()
+    CachedPath _cached;                     // lookup buffer, reused
+
+    // Bidirectional bookkeeping
+    std::uint32_t _mu = cInf;               // best meeting cost so far
+    std::size_t _meet = cNoCell;            // cell where the two trees join
+    int _side = Forward;                    // side expanding the current BFS level
+    std::size_t _levelLeft = 0;             // BFS nodes left in the current level
+
+    // Change log users: a view (trackChanges) and/or the trace recorder
+    bool _viewTracking = false;
+    bool _recording = false;
+    SearchTrace _trace;
+
+    // Change log lengths before a step, to record only that step's changes
+    struct LogMark { std::size_t n[2]; };
+
+private:
+    CellState stateOf(std::size_t i) const { return _scr[Forward].state(i); }
+    void setState(std::size_t i, CellState s) { _scr[Forward].setState(i, s); }
+    void setParentDir(std::size_t i, int dir) { _scr[Forward].setParentDir(i, dir); }
+    int parentDir(std::size_t i) const { return _scr[Forward].parentDir(i); }
+    std::uint32_t gOf(std::size_t i) const { return _scr[Forward].g(i); }
+    void setG(std::size_t i, std::uint32_t g) { _scr[Forward].setG(i, g); }
+
+    void syncChangeLog()
+    {
+        const bool on = _viewTracking || _recording;
+        for (int side = 0; side < 2; side++)
+            if (_scr[side].logsChanges() != on)
+                _scr[side].logChanges(on);
+    }
+
+    LogMark logMark() const { return {{_scr[Forward].changes().size(), _scr[Backward].changes().size()}}; }
+
+    // Appends the changes logged since the mark as one trace step
+    void recordSince(const LogMark& mark)
+    {
+        for (int side = 0; side < 2; side++)
+        {
+            const std::vector<CellIndex>& changes = _scr[side].changes();
+            for (std::size_t k = mark.n[side]; k < changes.size(); k++)
+                _trace.add(changes[k], state(changes[k]), isBackward(changes[k]));
+        }
+        _trace.endStep();
+        if (!_viewTracking)
+            clearChanges();
+    }
+
+    bool isBidirectional() const
+    {
+        return _opt.algorithm == Algorithm::BidirectionalBFS || _opt.algorithm == Algorithm::BidirectionalAStar;
+    }
+
+    // Heuristics the kernels are specialized on
+    struct NoHeuristic
+    {
+        static std::uint32_t eval(int, int, const Cell&) { return 0; }
+    };
+    struct ManhattanHeuristic
+    {
+        static std::uint32_t eval(int r, int c, const Cell& to) { return manhattanCost(std::abs(to.r-r), std::abs(to.c-c)); }
+    };
+    struct OctileHeuristic
+    {
+        static std::uint32_t eval(int r, int c, const Cell& to) { return octileCost(std::abs(to.r-r), std::abs(to.c-c)); }
+    };
+    struct ChebyshevHeuristic
+    {
+        static std::uint32_t eval(int r, int c, const Cell& to) { return chebyshevCost(std::abs(to.r-r), std::abs(to.c-c)); }
+    };
+    struct EuclideanHeuristic
+    {
+        static std::uint32_t eval(int r, int c, const Cell& to) { return euclideanCost(std::abs(to.r-r), std::abs(to.c-c)); }
+    };
+    // ALT: the geometric bound or the landmark bound, whichever is larger
+    template <class Base>
+    struct LandmarkHeuristic
+    {
+        const LandmarkTable* table;
+        std::uint32_t eval(int r, int c, const Cell& to) const { return std::max(Base::eval(r, c, to), table->bound(r, c, to)); }
+    };
+
+    // Calls fn(heuristic) with the policy selected in the options. ALT
+    // falls back to Auto until its tables are built.
+    template <class Fn>
+    decltype(auto) withHeuristic(Fn&& fn) const
+    {
+        switch (resolveHeuristic(_opt.heuristic, _opt.diagonal))
+        {
+            case HeuristicKind::Landmarks:
+                if (_landmarks && _landmarks->matches(*_grid, _opt.diagonal, _opt.corners, _opt.landmarks))
+                {
+                    if (_opt.diagonal) return fn(LandmarkHeuristic<OctileHeuristic>{_landmarks.get()});
+                    return fn(LandmarkHeuristic<ManhattanHeuristic>{_landmarks.get()});
+                }
+                if (_opt.diagonal) return fn(OctileHeuristic());
+                return fn(ManhattanHeuristic());
+            case HeuristicKind::Octile:    return fn(OctileHeuristic());
+            case HeuristicKind::Chebyshev: return fn(ChebyshevHeuristic());
+            case HeuristicKind::Euclidean: return fn(EuclideanHeuristic());
+            case HeuristicKind::Manhattan:
+            default:                       return fn(ManhattanHeuristic());
+        }
+    }
+
+    std::uint32_t estimate(const Cell& from, const Cell& to) const
+    {
+        return withHeuristic([&](auto h) { return h.eval(from.r, from.c, to); });
+    }
+
+    // Neighborhoods the kernels are specialized on: 4-connected, or
+    // 8-connected with a corner rule
+    template <bool Diagonal, CornerRule Corners = CornerRule::Cut>
+    struct Neighborhood
+    {
+        static constexpr int cDirs = Diagonal ? 8 : 4;
+        static bool allowed(unsigned walls, int dir) { return canMove<Corners>(walls, dir); }
+    };
+
+    // JPS prunes on the assumption that corners may be cut; under the other
+    // rules a JPS search runs as A*
+    bool usesJumpPoints() const
+    {
+        return _opt.algorithm == Algorithm::JPS && (!_opt.diagonal || _opt.corners == CornerRule::Cut);
+    }
+
+    // Appends the tree path from cell `from` to the root of one side's search
+    // (excluding `from`). JPS parents are jump points further back along the
+    // parent direction: walk back until the cell whose g accounts for the jump.
+    void appendChain(std::size_t from, const SearchScratch& scr, bool jumps)
+    {
+        const std::uint32_t maxSteps = std::uint32_t(std::max(_grid->rows(), _grid->cols()));
+        Cell t = _grid->cellAt(from);
+        for (;;)
+        {
+            const std::size_t ti = _grid->index(t);
+            const int dir = scr.parentDir(ti);
+            if (dir < 0) break;
+            const std::uint32_t gt = scr.g(ti);
+            const std::uint32_t cost = stepCost(dir);
+            for (std::uint32_t k = 1; k <= maxSteps; k++)
+            {
+                t.r -= cDirR[dir];
+                t.c -= cDirC[dir];
+                _path.push_back(t);
+                if (!jumps) break;
+                const std::uint32_t gq = scr.g(_grid->index(t));
+                if (gq != cInf && gq + k * cost == gt) break;
+            }
+        }
+    }
+
+    void markPath()
+    {
+        // mark state as path (leave visited/frontier for visualization)
+        for (const auto& p : _path)
+            setState(_grid->index(p), CellState::Path);
+    }
+
+    void rebuildPathFrom(std::size_t goalIdx)
+    {
+        _path.clear();
+        _path.push_back(_grid->cellAt(goalIdx));
+        appendChain(goalIdx, _scr[Forward], usesJumpPoints());
+        std::reverse(_path.begin(), _path.end());
+        markPath();
+    }
+
+    // start .. meet from the forward tree, then meet .. goal from the backward tree
+    void rebuildPathThrough(std::size_t meet)
+    {
+        _path.clear();
+        _path.push_back(_grid->cellAt(meet));
+        appendChain(meet, _scr[Forward], false);
+        std::reverse(_path.begin(), _path.end());
+        appendChain(meet, _scr[Backward], false);
+        markPath();
+    }
+
+    void finish(bool solved)
+    {
+        _finished = true;
+        _running = false;
+        _solved = solved;
+    }
+
+    // Calls fn(forwardList, backwardList) with the backend selected in the
+    // options; one switch per call
+    template <class Fn>
+    decltype(auto) withOpenList(Fn&& fn)
+    {
+        switch (_opt.openList)
+        {
+            case OpenListKind::QuaternaryHeap: return fn(_open[Forward].heap4, _open[Backward].heap4);
+            case OpenListKind::PairingHeap:    return fn(_open[Forward].pairing, _open[Backward].pairing);
+            case OpenListKind::BucketQueue:    return fn(_open[Forward].buckets, _open[Backward].buckets);
+            case OpenListKind::BinaryHeap:
+            default:                           return fn(_open[Forward].heap2, _open[Backward].heap2);
+        }
+    }
+
+    // Calls relax(cur, dir, stepCost) for every neighbor cur can move to; the
+    // neighborhood is a template parameter so the loop has a fixed trip count
+    template <class Moves, class Relax>
+    void forNeighbors(Cell cur, Relax&& relax) const
+    {
+        // border is padded with walls, so this also rejects off-grid cells
+        const unsigned walls = _grid->walls3x3(cur.r, cur.c);
+
+        // 4-neighborhood, then diagonals
+        for (int dir = 0; dir < Moves::cDirs; dir++)
+            if (Moves::allowed(walls, dir))
+                relax(cur, dir, stepCost(dir));
+    }
+
+    // Marks curIdx closed and calls relax(cur, dir, stepCost) for every neighbor
+    template <class Moves, class Relax>
+    void expandFrom(std::size_t curIdx, Relax&& relax)
+    {
+        // mark closed/visited
+        if (stateOf(curIdx) != CellState::Path) // don't overwrite path marker
+            setState(curIdx, CellState::Visited);
+        ++_expansions;
+
+        forNeighbors<Moves>(_grid->cellAt(curIdx), relax);
+    }
+
+    template <class Moves>
+    bool stepBFS()
+    {
+        const Grid& grid = *_grid;
+        auto& q = _q[Forward];
+        if (q.empty())
+        {
+            finish(false);
+            return false;
+        }
+        std::size_t curIdx = q.front(); q.pop();
+
+        if (curIdx == grid.index(_goal))
+        {
+            // reconstruct & finish
+            _pathCost = gOf(curIdx);
+            rebuildPathFrom(curIdx);
+            finish(true);
+            return true;
+        }
+
+        const std::uint32_t g = gOf(curIdx);
+        expandFrom<Moves>(curIdx, [&](Cell cur, int dir, std::uint32_t stepCost)
+        {
+            std::size_t ni = grid.index(cur.r + cDirR[dir], cur.c + cDirC[dir]);
+            if (stateOf(ni) == CellState::None) // unvisited/unseen
+            {
+                setState(ni, CellState::Frontier);
+                setParentDir(ni, dir);
+                setG(ni, g + stepCost);
+                q.push(CellIndex(ni));
+                ++_pushes;
+            }
+        });
+        return true;
+    }
+
+    // Pops the best live entry; cNoCell once the open list is exhausted
+    template <class Open>
+    std::size_t popOpen(Open& open, const SearchScratch& scr)
+    {
+        while (!open.empty())
+        {
+            OpenNode n = open.pop();
+            // Skip outdated entries (never happens with decrease-key backends)
+            if (Open::cDecreaseKey || n.g == scr.g(n.idx))
+                return n.idx;
+            ++_stalePops;
+        }
+        return cNoCell;
+    }
+
+    // Finishes the search if curIdx ends it (open list empty or goal reached)
+    bool finishedAt(std::size_t curIdx)
+    {
+        if (curIdx == cNoCell)
+        {
+            finish(false);
+            return true;
+        }
+        if (curIdx == _grid->index(_goal))
+        {
+            // reconstruct & finish
+            _pathCost = gOf(curIdx);
+            rebuildPathFrom(curIdx);
+            finish(true);
+            return true;
+        }
+        return false;
+    }
+
+    // Dijkstra (NoHeuristic) or A*
+    template <class Moves, class Heuristic, class Open>
+    bool stepBest(Open& open, const Heuristic& heuristic)
+    {
+        const Grid& grid = *_grid;
+        std::size_t curIdx = popOpen(open, _scr[Forward]);
+        if (finishedAt(curIdx))
+            return _solved;
+
+        const std::uint32_t g = gOf(curIdx);
+        expandFrom<Moves>(curIdx, [&](Cell cur, int dir, std::uint32_t stepCost)
+        {
+            int nr = cur.r + cDirR[dir], nc = cur.c + cDirC[dir];
+            std::size_t ni = grid.index(nr, nc);
+            std::uint32_t tentative = g + stepCost;
+            if (tentative < gOf(ni))
+            {
+                setG(ni, tentative);
+                setParentDir(ni, dir);
+                open.push(CellIndex(ni), tentative + heuristic.eval(nr, nc, _goal), tentative);
+                ++_pushes;
+                if (stateOf(ni) != CellState::Visited) // keep solved path marking later
+                    setState(ni, CellState::Frontier);
+            }
+        });
+        return true;
+    }
+
+    template <class Heuristic, class Open>
+    bool stepJPS(Open& open, const Heuristic& heuristic)
+    {
+        const Grid& grid = *_grid;
+        std::size_t curIdx = popOpen(open, _scr[Forward]);
+        if (finishedAt(curIdx))
+            return _solved;
+
+        if (stateOf(curIdx) != CellState::Path)
+            setState(curIdx, CellState::Visited);
+        ++_expansions;
+
+        const std::uint32_t g = gOf(curIdx);
+        _jps.successors(grid.cellAt(curIdx), parentDir(curIdx), [&](Cell jp, int dir, int steps)
+        {
+            std::size_t ni = grid.index(jp);
+            std::uint32_t tentative = g + std::uint32_t(steps) * stepCost(dir);
+            if (tentative < gOf(ni))
+            {
+                setG(ni, tentative);
+                setParentDir(ni, dir);
+                open.push(CellIndex(ni), tentative + heuristic.eval(jp.r, jp.c, _goal), tentative);
+                ++_pushes;
+                if (stateOf(ni) != CellState::Visited)
+                    setState(ni, CellState::Frontier);
+            }
+        });
+        return true;
+    }
+
+    // A cell labeled by both sides joins the trees; keep the cheapest join
+    void checkMeet(std::size_t i)
+    {
+        const std::uint32_t gF = _scr[Forward].g(i), gB = _scr[Backward].g(i);
+        if (gF != cInf && gB != cInf && gF + gB < _mu)
+        {
+            _mu = gF + gB;
+            _meet = i;
+        }
+    }
+
+    void finishThrough()
+    {
+        _pathCost = _mu;
+        rebuildPathThrough(_meet);
+        finish(true);
+    }
+
+    // Level-synchronous: expand a whole BFS level of the smaller side, and stop
+    // after the level in which the two frontiers first touched.
+    template <class Moves>
+    bool stepBiBFS()
+    {
+        if (_levelLeft == 0)
+        {
+            if (_meet != cNoCell)
+            {
+                finishThrough();
+                return true;
+            }
+            if (_q[Forward].empty() || _q[Backward].empty())
+            {
+                finish(false);
+                return false;
+            }
+            _side = (_q[Forward].size() <= _q[Backward].size()) ? Forward : Backward;
+            _levelLeft = _q[_side].size();
+        }
+
+        const Grid& grid = *_grid;
+        const int side = _side;
+        SearchScratch& scr = _scr[side];
+        auto& q = _q[side];
+
+        std::size_t curIdx = q.front(); q.pop();
+        --_levelLeft;
+
+        if (scr.state(curIdx) != CellState::Path)
+            scr.setState(curIdx, CellState::Visited);
+        ++_expansions;
+
+        const std::uint32_t gCur = scr.g(curIdx);
+        forNeighbors<Moves>(grid.cellAt(curIdx), [&](Cell cur, int dir, std::uint32_t stepCost)
+        {
+            std::size_t ni = grid.index(cur.r + cDirR[dir], cur.c + cDirC[dir]);
+            if (scr.state(ni) == CellState::None)
+            {
+                scr.setState(ni, CellState::Frontier);
+                scr.setParentDir(ni, dir);
+                scr.setG(ni, gCur + stepCost);
+                q.push(CellIndex(ni));
+                ++_pushes;
+                checkMeet(ni);
+            }
+        });
+        return true;
+    }
+
+    // Alternates sides by open-list size. Both sides share one balanced
+    // potential (Ikeda; Goldberg and Harrelson): forward keys are
+    // 2g + h(v, goal) - h(v, start) + c and backward keys the mirror image,
+    // with c = max(h(start, goal), h(goal, start)) keeping them non-negative
+    // (doubled so they stay integers). Any path through v then costs
+    // (keyF(v) + keyB(v)) / 2 - c, so the search stops once the two minimum
+    // keys reach 2 (mu + c). Cells whose own g + h already reaches mu are
+    // neither expanded nor pushed: any join through them costs at least as much.
+    template <class Moves, class Heuristic, class Open>
+    bool stepBiAStar(Open& fwd, Open& bwd, const Heuristic& heuristic)
+    {
+        Open* open[2] = {&fwd, &bwd};
+
+        if (fwd.empty() || bwd.empty())
+        {
+            if (_meet != cNoCell) finishThrough();
+            else finish(false);
+            return _solved;
+        }
+        const std::uint32_t offset = biOffset(heuristic);
+        if (_meet != cNoCell && std::uint64_t(fwd.top().f) + bwd.top().f >= 2 * (std::uint64_t(_mu) + offset))
+        {
+            finishThrough();
+            return true;
+        }
+
+        const Grid& grid = *_grid;
+        const int side = (fwd.size() <= bwd.size()) ? Forward : Backward;
+        SearchScratch& scr = _scr[side];
+        const Cell& target = (side == Forward) ? _goal : _start;
+        const Cell& source = (side == Forward) ? _start : _goal;
+
+        std::size_t curIdx = popOpen(*open[side], scr);
+        if (curIdx == cNoCell)
+            return true;    // only stale entries left on this side; re-check next step
+
+        const std::uint32_t gCur = scr.g(curIdx);
+        const Cell curCell = grid.cellAt(curIdx);
+        if (_meet != cNoCell && gCur + heuristic.eval(curCell.r, curCell.c, target) >= _mu)
+            return true;    // pruned
+
+        if (scr.state(curIdx) != CellState::Path)
+            scr.setState(curIdx, CellState::Visited);
+        ++_expansions;
+
+        forNeighbors<Moves>(curCell, [&](Cell cur, int dir, std::uint32_t stepCost)
+        {
+            int nr = cur.r + cDirR[dir], nc = cur.c + cDirC[dir];
+            std::size_t ni = grid.index(nr, nc);
+            std::uint32_t tentative = gCur + stepCost;
+            if (tentative < scr.g(ni))
+            {
+                const std::uint32_t h = heuristic.eval(nr, nc, target);
+                if (_meet != cNoCell && tentative + h >= _mu)
+                    return;     // pruned
+                scr.setG(ni, tentative);
+                scr.setParentDir(ni, dir);
+                open[side]->push(CellIndex(ni), 2 * tentative + h + offset - heuristic.eval(nr, nc, source), tentative);
+                ++_pushes;
+                if (scr.state(ni) != CellState::Visited)
+                    scr.setState(ni, CellState::Frontier);
+                checkMeet(ni);
+            }
+        });
+        return true;
+    }
+
+    // The constant c of the balanced Bi-A* keys (see stepBiAStar). Every
+    // heuristic here obeys the triangle inequality, so
+    // h(v, goal) - h(v, start) + c >= 0 and the key of the endpoints is 2c.
+    template <class Heuristic>
+    std::uint32_t biOffset(const Heuristic& heuristic) const
+    {
+        return std::max(heuristic.eval(_start.r, _start.c, _goal), heuristic.eval(_goal.r, _goal.c, _start));
+    }
+
+    bool stepDStar()
+    {
+        if (_dstar.done())
+        {
+            const std::uint32_t cost = _dstar.startCost();
+            if (cost == DStarLite::cInf)
+            {
+                finish(false);
+                return false;
+            }
+            _pathCost = cost;
+            _dstar.path(_path);
+            markPath();
+            finish(true);
+            return true;
+        }
+        _dstar.step([this](std::size_t i)
+        {
+            if (stateOf(i) != CellState::Path)
+                setState(i, CellState::Visited);
+            ++_expansions;
+        },
+        [this](std::size_t i)
+        {
+            if (stateOf(i) == CellState::None)
+                setState(i, CellState::Frontier);
+            ++_pushes;
+        });
+        return true;
+    }
+
+    // (Re)builds the HPA* graph unless it matches the grid and options; a
+    // graph shared with other engines is left to them
+    void syncHierarchy()
+    {
+        if (_hierarchy && _hierarchy->matches(*_grid, _opt.diagonal, _opt.corners, _opt.clusterSize))
+            return;
+        if (!_hierarchy || _hierarchy.use_count() > 1)
+            _hierarchy = std::make_shared<PathHierarchy>();
+        _hierarchy->build(*_grid, _opt.diagonal, _opt.corners, _opt.clusterSize, _cancel);
+    }
+
+    // (Re)builds the ALT tables unless they match the grid and options;
+    // tables shared with other engines are left to them
+    void syncLandmarks()
+    {
+        if (_landmarks && _landmarks->matches(*_grid, _opt.diagonal, _opt.corners, _opt.landmarks))
+            return;
+        if (!_landmarks || _landmarks.use_count() > 1)
+            _landmarks = std::make_shared<LandmarkTable>();
+        _landmarks->build(*_grid, _opt.diagonal, _opt.corners, _opt.landmarks, _cancel);
+    }
+
+    // begin() was stopped by the cancel flag inside a table build: not
+    // running, so the next step() begins again
+    void abandonBegin()
+    {
+        _running = false;
+        _finished = false;
+    }
+
+    // One abstract expansion; once done, the path is refined in one go. The
+    // cells the local searches settle (joining start and goal, refining)
+    // count as expansions too, but are not drawn.
+    bool stepHPA()
+    {
+        if (_hpa.done())
+        {
+            if (!_hpa.found())
+            {
+                _expansions += _hpa.localExpansions();
+                finish(false);
+                return false;
+            }
+            if (!_hpa.path(_path, _cancel))
+                return true;    // refined again by the next step
+            _pathCost = _hpa.cost();
+            _expansions += _hpa.localExpansions();
+            markPath();
+            finish(true);
+            return true;
+        }
+        _hpa.step([this](const Cell& cell)
+        {
+            const std::size_t i = _grid->index(cell);
+            if (stateOf(i) != CellState::Path)
+                setState(i, CellState::Visited);
+            ++_expansions;
+        },
+        [this](const Cell& cell)
+        {
+            const std::size_t i = _grid->index(cell);
+            if (stateOf(i) == CellState::None)
+                setState(i, CellState::Frontier);
+            ++_pushes;
+        });
+        return true;
+    }
+
+    void notePeak(std::size_t openSize) { _peakOpen = std::max(_peakOpen, openSize); }
+
+    // Calls fn(kernel), where kernel() performs one step of the search chosen
+    // in the options (and updates the peak open size). The kernel is
+    // instantiated for the algorithm, neighborhood, heuristic and open list,
+    // so its inner loop has no option checks; the choice is made once per
+    // call, not per step or per neighbor. The kernel refers to the heuristic
+    // and open lists of this call, so fn must not keep it.
+    template <class Fn>
+    decltype(auto) withKernel(Fn&& fn)
+    {
+        if (!_opt.diagonal)
+            return withKernel<Neighborhood<false>>(fn);
+        switch (_opt.corners)
+        {
+            case CornerRule::NoSqueeze: return withKernel<Neighborhood<true, CornerRule::NoSqueeze>>(fn);
+            case CornerRule::NoCut:     return withKernel<Neighborhood<true, CornerRule::NoCut>>(fn);
+            case CornerRule::Cut:
+            default:                    return withKernel<Neighborhood<true>>(fn);
+        }
+    }
+
+    template <class M, class Fn>
+    decltype(auto) withKernel(Fn&& fn)
+    {
+        switch (_opt.algorithm)
+        {
+            case Algorithm::BFS:
+                return fn([this] { const bool p = stepBFS<M>(); notePeak(_q[Forward].size()); return p; });
+            case Algorithm::BidirectionalBFS:
+                return fn([this] { const bool p = stepBiBFS<M>(); notePeak(_q[Forward].size() + _q[Backward].size()); return p; });
+            case Algorithm::DStarLite:
+                return fn([this] { const bool p = stepDStar(); notePeak(_dstar.queueSize()); return p; });
+            case Algorithm::HPAStar:
+                return fn([this] { const bool p = stepHPA(); notePeak(_hpa.queueSize()); return p; });
+            case Algorithm::BidirectionalAStar:
+                return withHeuristic([&](const auto& h) -> decltype(auto)
+                {
+                    return withOpenList([&](auto& fwd, auto& bwd) -> decltype(auto)
+                    {
+                        return fn([this, &fwd, &bwd, &h] { const bool p = stepBiAStar<M>(fwd, bwd, h); notePeak(fwd.size() + bwd.size()); return p; });
+                    });
+                });
+            case Algorithm::Dijkstra:
+                return withOpenList([&](auto& open, auto&) -> decltype(auto)
+                {
+                    return fn([this, &open] { const bool p = stepBest<M>(open, NoHeuristic()); notePeak(open.size()); return p; });
+                });
+            case Algorithm::JPS:
+                if (usesJumpPoints())
+                {
+                    return withHeuristic([&](const auto& h) -> decltype(auto)
+                    {
+                        return withOpenList([&](auto& open, auto&) -> decltype(auto)
+                        {
+                            return fn([this, &open, &h] { const bool p = stepJPS(open, h); notePeak(open.size()); return p; });
+                        });
+                    });
+                }
+                [[fallthrough]];
+            case Algorithm::AStar:
+            default:
+                return withHeuristic([&](const auto& h) -> decltype(auto)
+                {
+                    return withOpenList([&](auto& open, auto&) -> decltype(auto)
+                    {
+                        return fn([this, &open, &h] { const bool p = stepBest<M>(open, h); notePeak(open.size()); return p; });
+                    });
+                });
+        }
+    }
+
+    bool advance()
+    {
+        return withKernel([](auto&& kernel) { return kernel(); });
+    }
+
+public:
+    SearchEngine() = default;
+    explicit SearchEngine(const Grid& grid) { attach(grid); }
+
+    // Binds the engine to a grid and sizes the scratch buffers for it.
+    // Must be called again whenever the grid is resized.
+    void attach(const Grid& grid)
+    {
+        _grid = &grid;
+        const std::size_t n = grid.size();
+        _cells = n;
+        _scr[Forward].resize(n);
+        _scr[Backward].release();
+        _open[Forward].resizeCells(n);
+        _open[Backward].resizeCells(n);
+        _dstar.attach(grid);
+        clear();
+    }
+
+    const Grid* grid() const { return _grid; }
+
+    Options& options() { return _opt; }
+    const Options& options() const { return _opt; }
+
+    // O(1) apart from the few containers the last search filled
+    void clear()
+    {
+        _scr[Forward].reset();
+        _scr[Backward].reset();
+        _path.clear();
+        _running = false;
+        _finished = false;
+        _solved = false;
+        _pathCost = 0;
+        _expansions = 0;
+        _pushes = 0;
+        _stalePops = 0;
+        _peakOpen = 0;
+        _mu = cInf;
+        _meet = cNoCell;
+        _levelLeft = 0;
+        // clear search containers
+        for (int side = 0; side < 2; side++)
+        {
+            _open[side].clear();
+            _q[side].clear();
+        }
+    }
+
+    bool isRunning() const { return _running; }
+    bool isFinished() const { return _finished; }
+    bool isSolved() const { return _solved; }
+
+    // Forward state wins; cells only the backward side touched report its state
+    CellState state(std::size_t i) const
+    {
+        CellState s = stateOf(i);
+        if (s == CellState::None && !_scr[Backward].empty())
+            s = _scr[Backward].state(i);
+        return s;
+    }
+
+    // True if state(i) comes from the backward frontier of a bidirectional search
+    bool isBackward(std::size_t i) const
+    {
+        return !_scr[Backward].empty() && stateOf(i) == CellState::None && _scr[Backward].state(i) != CellState::None;
+    }
+
+    const std::vector<Cell>& path() const { return _path; }
+    std::size_t pathLength() const { return _path.size(); }
+    long long pathCost() const { return _solved ? (long long)_pathCost : -1; }
+    std::uint64_t expansions() const { return _expansions; }
+    std::uint64_t pushes() const { return _pushes; }
+    // Popped entries that were superseded by a cheaper push (lazy-deletion backends)
+    std::uint64_t stalePops() const { return _stalePops; }
+    std::size_t jumpTableBytes() const { return _jps.tableBytes(); }
+
+    std::size_t visitedCount() const
+    {
+        return _scr[Forward].count(CellState::Visited) + _scr[Backward].count(CellState::Visited);
+    }
+
+    std::size_t frontierCount() const
+    {
+        return _scr[Forward].count(CellState::Frontier) + _scr[Backward].count(CellState::Frontier);
+    }
+
+    // Entries waiting in the open list(s) or BFS queue(s) of the current search
+    std::size_t openSize() const
+    {
+        if (_opt.algorithm == Algorithm::BFS || _opt.algorithm == Algorithm::BidirectionalBFS)
+            return _q[Forward].size() + _q[Backward].size();
+        if (_opt.algorithm == Algorithm::DStarLite)
+            return _dstar.queueSize();
+        if (_opt.algorithm == Algorithm::HPAStar)
+            return _hpa.queueSize();
+        switch (_opt.openList)
+        {
+            case OpenListKind::QuaternaryHeap: return _open[Forward].heap4.size() + _open[Backward].heap4.size();
+            case OpenListKind::PairingHeap:    return _open[Forward].pairing.size() + _open[Backward].pairing.size();
+            case OpenListKind::BucketQueue:    return _open[Forward].buckets.size() + _open[Backward].buckets.size();
+            case OpenListKind::BinaryHeap:
+            default:                           return _open[Forward].heap2.size() + _open[Backward].heap2.size();
+        }
+    }
+
+    std::size_t peakOpen() const { return _peakOpen; }
+
+    // Change tracking for views: while enabled, every cell whose state()
+    // changes is recorded until clearChanges()
+    void trackChanges(bool on)
+    {
+        _viewTracking = on;
+        syncChangeLog();
+    }
+
+    // True if a reset dropped states wholesale; treat every cell as changed
+    bool changedAll() const { return _scr[Forward].changesLost() || _scr[Backward].changesLost(); }
+
+    // Calls fn(cellIndex) for every logged change (a cell may be reported twice)
+    template <class Fn>
+    void forEachChange(Fn&& fn) const
+    {
+        for (int side = 0; side < 2; side++)
+            for (CellIndex i : _scr[side].changes())
+                fn(std::size_t(i));
+    }
+
+    std::size_t changeCount() const { return _scr[Forward].changes().size() + _scr[Backward].changes().size(); }
+
+    void clearChanges()
+    {
+        _scr[Forward].clearChanges();
+        _scr[Backward].clearChanges();
+    }
+
+    // Trace recording: while enabled, every begin() starts a new trace and
+    // every step() appends to it. Turning it off frees the trace.
+    void recordTrace(bool on)
+    {
+        _recording = on;
+        if (!on)
+            _trace.release();
+        syncChangeLog();
+    }
+    bool recordingTrace() const { return _recording; }
+    const SearchTrace& trace() const { return _trace; }
+
+    SearchStats stats() const
+    {
+        SearchStats st;
+        st.visited = visitedCount();
+        st.frontier = frontierCount();
+        st.openSize = openSize();
+        st.peakOpen = _peakOpen;
+        st.expansions = _expansions;
+        st.pushes = _pushes;
+        st.stalePops = _stalePops;
+        st.pathLength = pathLength();
+        st.pathCost = pathCost();
+        return st;
+    }
+
+    // Starts a search between the grid's own start and goal
+    void begin() { begin(_grid->start(), _grid->goal()); }
+
+    // Starts a search between arbitrary free cells; the grid is not modified
+    void begin(Cell start, Cell goal)
+    {
+        if (isBidirectional() && _scr[Backward].size() != _cells)
+            _scr[Backward].resize(_cells);
+
+        clear();
+        _start = start;
+        _goal = goal;
+        const LogMark mark = logMark();
+
+        const Cell& st = _start;
+        CellIndex s = CellIndex(_grid->index(st));
+        setG(s, 0);
+        setState(s, CellState::Frontier);
+
+        // endpoints in different components: no path, nothing to search
+        const bool cutOff = _components && _components->matches(*_grid, _opt.diagonal, _opt.corners) &&
+                            !_components->connected(_start, _goal);
+
+        if (!cutOff)
+        {
+            if (_opt.heuristic == HeuristicKind::Landmarks && usesHeuristic(_opt.algorithm))
+            {
+                syncLandmarks();
+                if (cancelled(_cancel)) return abandonBegin();
+            }
+            switch (_opt.algorithm)
+            {
+                case Algorithm::BFS:
+                    _q[Forward].push(s);
+                    break;
+
+                case Algorithm::BidirectionalBFS:
+                case Algorithm::BidirectionalAStar:
+                {
+                    const Cell& gl = _goal;
+                    CellIndex t = CellIndex(_grid->index(gl));
+                    _scr[Backward].setG(t, 0);
+                    _scr[Backward].setState(t, CellState::Frontier);
+                    if (_opt.algorithm == Algorithm::BidirectionalBFS)
+                    {
+                        _q[Forward].push(s);
+                        _q[Backward].push(t);
+                    }
+                    else
+                    {
+                        withOpenList([&](auto& fwd, auto& bwd)
+                        {
+                            // balanced keys, see stepBiAStar
+                            const std::uint32_t hF = estimate(st, gl), hB = estimate(gl, st);
+                            const std::uint32_t offset = std::max(hF, hB);
+                            fwd.push(s, hF + offset, 0);
+                            bwd.push(t, hB + offset, 0);
+                        });
+                    }
+                    checkMeet(s);   // start == goal
+                    break;
+                }
+
+                case Algorithm::DStarLite:
+                    // searches from the goal, reusing what the previous search found
+                    _dstar.begin(_start, _goal, _opt.diagonal, _opt.corners, _cancel);
+                    break;
+
+                case Algorithm::HPAStar:
+                    syncHierarchy();
+                    if (cancelled(_cancel)) return abandonBegin();
+                    _hpa.resetLocalExpansions();
+                    _hpa.begin(*_hierarchy, _start, _goal, [](const Cell&) {});
+                    break;
+
+                default:
+                {
+                    if (usesJumpPoints())
+                    {
+                        _jps.setup(*_grid, _goal, _opt.diagonal, _opt.jumpTable);
+                        if (_opt.jumpTable && !_jps.hasTable())
+                            _jps.buildTable(_cancel);
+                    }
+                    std::uint32_t f0 = (_opt.algorithm == Algorithm::Dijkstra) ? 0 : estimate(st, _goal);
+                    withOpenList([&](auto& open, auto&) { open.push(s, f0, 0); });
+                    break;
+                }
+            }
+            if (cancelled(_cancel)) return abandonBegin();     // JPS+ table or D* Lite reset
+        }
+
+        _running = true;
+        _finished = false;
+        _solved = false;
+        _peakOpen = openSize();
+        if (cutOff)
+            finish(false);
+
+        if (_recording)
+        {
+            _trace.reset(_cells, _grid->cols());
+            recordSince(mark);
+        }
+    }
+
+    // Returns: true if state changed (progress), false if already finished
+    bool step()
+    {
+        if (!_running)
+            begin();
+
+        if (!_running || _finished)
+            return false;
+
+        const LogMark mark = logMark();
+        const bool progressed = advance();
+        if (_recording)
+            recordSince(mark);
+        return progressed;
+    }
+
+    // Runs a fresh search to completion without any per-step callbacks.
+    // Returns true if a path was found.
+    bool run() { return run(_grid->start(), _grid->goal()); }
+
+    bool run(Cell start, Cell goal)
+    {
+        // recorded runs need their steps, so they always search
+        const bool cached = _cache && !_recording && !_grid->isWall(start) && !_grid->isWall(goal);
+        if (cached)
+        {
+            if (_cache->lookup(*_grid, cacheKey(start, goal), findsLeastCost(_opt.algorithm, _opt.heuristic, _opt.diagonal), _cached))
+            {
+                clear();
+                _start = start;
+                _goal = goal;
+                _path.swap(_cached.path);
+                _pathCost = _cached.cost;
+                markPath();
+                finish(_cached.solved);
+                return _solved;
+            }
+        }
+        search(start, goal);
+        if (cached)
+        {
+            _cached.solved = _solved;
+            _cached.cost = _pathCost;
+            _cached.path.assign(_path.begin(), _path.end());
+            _cache->store(*_grid, cacheKey(start, goal), _cached);
+        }
+        return _solved;
+    }
+
+    // Path cache consulted by run() (not owned; nullptr = none). Shared
+    // caches may be used by several engines at once.
+    void useCache(PathCache* cache) { _cache = cache; }
+    PathCache* cache() const { return _cache; }
+
+private:
+    PathKey cacheKey(Cell start, Cell goal) const
+    {
+        PathKey key;
+        key.start = start;
+        key.goal = goal;
+        key.algorithm = _opt.algorithm;
+        key.diagonal = _opt.diagonal;
+        key.corners = _opt.diagonal ? _opt.corners : CornerRule::Cut;
+        if (usesHeuristic(_opt.algorithm))
+            key.heuristic = resolveHeuristic(_opt.heuristic, _opt.diagonal);
+        if (_opt.algorithm == Algorithm::HPAStar)
+            key.clusterSize = _opt.clusterSize;
+        return key;
+    }
+
+    void search(Cell start, Cell goal)
+    {
+        begin(start, goal);
+        // begin() finishes at once when the goal is known to be unreachable
+        if (_recording)
+        {
+            // the trace takes one record per step()
+            while (!_finished && step())
+                ;
+            return;
+        }
+        withKernel([this](auto&& kernel)
+        {
+            while (!_finished && kernel())
+                ;
+        });
+    }
+
+public:
+
+    // JPS+: builds the jump table for the current grid now (if not valid yet)
+    // so that the first query does not pay for it
+    void prepareJumpTable()
+    {
+        if (_opt.diagonal && _opt.corners != CornerRule::Cut)
+            return;     // jump points are not used under this corner rule
+        _jps.setup(*_grid, _grid->goal(), _opt.diagonal, true);
+        if (!_jps.hasTable())
+            _jps.buildTable();
+    }
+
+    // Stop request checked by the long parts of begin() and step(): the
+    // JPS+, ALT and HPA* table builds, D* Lite starting over and HPA* path
+    // refinement (not owned; nullptr = none). A cancelled begin() leaves the
+    // engine not running; a cancelled refinement is redone by the next step().
+    void setCancelFlag(CancelFlag cancel) { _cancel = cancel; }
+
+    // Connectivity index to reject unreachable goals in begin() (not owned;
+    // nullptr = none). Used only while it matches the grid and the movement
+    // options; the owner keeps it current.
+    void useConnectivity(const ConnectivityIndex* index) { _components = index; }
+
+    // The wall at cell was toggled (call right after each edit). The next D*
+    // Lite search then only repairs what the edit affected, and the HPA*
+    // graph rebuilds only the clusters around the cell; any grid change not
+    // reported this way makes both start from scratch. ALT tables are
+    // rebuilt by the next search that uses them.
+    void wallChanged(Cell cell)
+    {
+        _dstar.wallChanged(cell);
+        if (_hierarchy && _hierarchy.use_count() > 1)
+            _hierarchy.reset();     // shared read-only; the next HPA* search builds a private copy
+        else if (_hierarchy)
+            _hierarchy->wallChanged(cell);
+    }
+
+    // D* Lite: frees the values kept for replanning; the next search starts over
+    void dropIncremental() { _dstar.release(); }
+
+    // JPS+: use the jump table another engine built for the same grid instead
+    // of building a private copy (the table is shared, read-only)
+    void shareJumpTable(const SearchEngine& other) { _jps.shareTable(other._jps); }
+
+    // HPA*: builds the abstract graph for the current grid and options now
+    // (if not valid yet) so that the first query does not pay for it
+    void prepareHierarchy() { syncHierarchy(); }
+
+    // HPA*: use the graph another engine built for the same grid (shared,
+    // read-only; an edit reported to this engine drops the share)
+    void shareHierarchy(const SearchEngine& other) { _hierarchy = other._hierarchy; }
+
+    // HPA* graph, nullptr until the first HPA* search or prepareHierarchy()
+    const PathHierarchy* hierarchy() const { return _hierarchy.get(); }
+
+    // ALT: builds the landmark tables for the current grid and options now
+    void prepareLandmarks() { syncLandmarks(); }
+
+    // ALT: use the tables another engine built for the same grid (shared,
+    // read-only; after an edit this engine builds its own)
+    void shareLandmarks(const SearchEngine& other) { _landmarks = other._landmarks; }
+
+    // ALT: use tables built or loaded elsewhere (e.g. from a maze file); they
+    // are used while they match the grid and options, like shared ones
+    void useLandmarks(std::shared_ptr<LandmarkTable> table) { _landmarks = std::move(table); }
+
+    // ALT tables, nullptr until the first ALT search or prepareLandmarks()
+    const LandmarkTable* landmarks() const { return _landmarks.get(); }
+};
+
+} // namespace maze
@@ -0,0 +1,156 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <cstddef>
+#include <cstdint>
+
+#include "MazeTypes.h"
+
+namespace maze
+{
+
+// Per-cell scratch of one search direction: g, CellState and parent direction.
+//
+// Every slot carries the generation it was written in; a slot whose stamp is
+// not the current generation reads as untouched (g = inf, no state, no
+// parent). reset() only bumps the generation, so starting a new search costs
+// O(1) instead of refilling all cells, and a query pays only for the cells it
+// actually reaches. The slots are wiped once every 65535 resets when the
+// 16-bit generation wraps.
+//
+// The number of cells in each CellState is kept up to date by setState(), so
+// statistics never need a scan. Optionally every state change is logged, so a
+// view can repaint only the cells that changed.
+//
+// Slot layout: g (4 bytes), stamp (2), info (1: 2 bits CellState, 4 bits
+// parent direction + 1), padded to 8 bytes so all of a cell's scratch is read
+// with one load.
+class SearchScratch
+{
+public:
+    static constexpr std::uint32_t cInf = std::numeric_limits<std::uint32_t>::max();
+
+private:
+    static constexpr std::uint8_t cStateMask = 0x03;
+    static constexpr int cDirShift = 2;
+
+    struct Slot
+    {
+        std::uint32_t g;
+        std::uint16_t stamp;
+        std::uint8_t info;
+    };
+
+    std::vector<Slot> _slots;
+    std::uint16_t _gen = 1;
+    std::size_t _counts[4] = {};        // cells per CellState in this generation
+
+    bool _logChanges = false;
+    bool _changesLost = false;          // reset() dropped states that were not logged as changes
+    std::vector<CellIndex> _changes;    // cells whose state changed since clearChanges()
+
+    // All states vanish at once: the log can no longer list them
+    void dropChanges()
+    {
+        if (!_logChanges) return;
+        _changesLost = true;
+        _changes.clear();
+    }
+
+    // Slot for writing; reinitialized on the first touch in this generation
+    Slot& touch(std::size_t i)
+    {
+        Slot& s = _slots[i];
+        if (s.stamp != _gen)
+        {
+            s.g = cInf;
+            s.stamp = _gen;
+            s.info = 0;
+        }
+        return s;
+    }
+
+    std::uint8_t info(std::size_t i) const { return touched(i) ? _slots[i].info : 0; }
+
+public:
+    void resize(std::size_t cells)
+    {
+        _slots.assign(cells, Slot{cInf, 0, 0});
+        _gen = 1;
+        std::fill(std::begin(_counts), std::end(_counts), 0);
+        dropChanges();
+    }
+
+    void release()
+    {
+        _slots.clear();
+        _slots.shrink_to_fit();
+        std::fill(std::begin(_counts), std::end(_counts), 0);
+        dropChanges();
+    }
+
+    std::size_t size() const { return _slots.size(); }
+    bool empty() const { return _slots.empty(); }
+    std::size_t memoryBytes() const { return _slots.capacity() * sizeof(Slot); }
+
+    // Forgets every cell in O(1)
+    void reset()
+    {
+        if (count(CellState::Visited) || count(CellState::Frontier) || count(CellState::Path))
+            dropChanges();
+        std::fill(std::begin(_counts), std::end(_counts), 0);
+        if (++_gen == 0)
+        {
+            for (auto& s : _slots)
+                s.stamp = 0;
+            _gen = 1;
+        }
+    }
+
+    bool touched(std::size_t i) const { return _slots[i].stamp == _gen; }
+
+    std::uint32_t g(std::size_t i) const { return touched(i) ? _slots[i].g : cInf; }
+    void setG(std::size_t i, std::uint32_t g) { touch(i).g = g; }
+
+    CellState state(std::size_t i) const { return CellState(info(i) & cStateMask); }
+    void setState(std::size_t i, CellState s)
+    {
+        Slot& slot = touch(i);
+        const std::uint8_t old = slot.info & cStateMask;
+        // _counts[None] is never read; it only absorbs the first transition
+        _counts[old]--;
+        _counts[std::uint8_t(s)]++;
+        if (_logChanges && old != std::uint8_t(s))
+            _changes.push_back(CellIndex(i));
+        slot.info = std::uint8_t((slot.info & ~cStateMask) | std::uint8_t(s));
+    }
+
+    // Direction of the move that reached the cell, -1 for the root / untouched
+    int parentDir(std::size_t i) const { return (info(i) >> cDirShift) - 1; }
+    void setParentDir(std::size_t i, int dir)
+    {
+        Slot& slot = touch(i);
+        slot.info = std::uint8_t((slot.info & cStateMask) | ((dir + 1) << cDirShift));
+    }
+
+    // Cells currently in state s (not meaningful for CellState::None)
+    std::size_t count(CellState s) const { return _counts[std::uint8_t(s)]; }
+
+    bool logsChanges() const { return _logChanges; }
+    void logChanges(bool on)
+    {
+        _logChanges = on;
+        clearChanges();
+    }
+    bool changesLost() const { return _changesLost; }
+    const std::vector<CellIndex>& changes() const { return _changes; }
+    void clearChanges()
+    {
+        _changes.clear();
+        _changesLost = false;
+    }
+};
+
+} // namespace maze
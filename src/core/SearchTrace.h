@@ -0,0 +1,255 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <cstddef>
+#include <cstdint>
+
+#include "MazeTypes.h"
+#include "StateMirror.h"
+
+namespace maze
+{
+
+// Compact recording of one search run: for every step the cells whose state
+// changed, with their new state. Step 0 is the state right after begin().
+//
+// Events are stored as varints: per step the event count, then one varint per
+// event with the backward-side bit and the CellState in the low 3 bits. A cell
+// that is one of the 8 neighbours of the previous event's cell (the usual case:
+// an expansion, then its pushes around it) is coded by direction and takes one
+// byte; any other cell by the zig-zag delta of its index.
+//
+// Keyframes store the complete state (all non-empty cells in index order,
+// encoded the same way) so replay can start near any step. A keyframe is taken
+// once the events written since the previous one are twice the size of that
+// keyframe, so keyframes take less space than the events and seeking decodes
+// at most about two keyframes' worth of events.
+class SearchTrace
+{
+    friend class TracePlayer;
+
+    // No keyframe before this many event bytes (small runs need none)
+    static constexpr std::size_t cMinKeyGap = std::size_t(64) << 10;
+
+    struct Keyframe
+    {
+        std::size_t records;        // steps applied at this point
+        std::size_t offset;         // event bytes of those steps
+        CellIndex base;             // delta base for the next event
+        std::size_t snapBegin;      // state in _snap[snapBegin, snapEnd)
+        std::size_t snapEnd;
+    };
+
+    std::vector<std::uint8_t> _events;
+    std::vector<std::uint8_t> _snap;
+    std::vector<Keyframe> _keys;
+    std::size_t _records = 0;
+    CellIndex _base = 0;
+    std::int64_t _near[8] = {};         // index deltas of the 8 neighbours
+
+    // Current state, needed for keyframes
+    StateMirror _live;
+    std::vector<std::uint64_t> _step;   // encoded events of the step being recorded
+    std::vector<CellIndex> _sorted;     // keyframe scratch
+
+    static void putVarint(std::vector<std::uint8_t>& out, std::uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            out.push_back(std::uint8_t(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back(std::uint8_t(v));
+    }
+
+    static std::uint64_t getVarint(const std::uint8_t*& p)
+    {
+        std::uint64_t v = 0;
+        for (int shift = 0;; shift += 7)
+        {
+            const std::uint8_t b = *p++;
+            v |= std::uint64_t(b & 0x7F) << shift;
+            if (b < 0x80)
+                return v;
+        }
+    }
+
+    // Bits 0-2: backward, state; bit 3: neighbour; then direction or zig-zag delta
+    std::uint64_t encode(CellIndex& base, std::size_t i, CellState s, bool backward) const
+    {
+        const std::uint64_t low = (std::uint64_t(s) << 1) | (backward ? 1u : 0u);
+        const std::int64_t d = std::int64_t(i) - std::int64_t(base);
+        base = CellIndex(i);
+        for (int dir = 0; dir < 8; dir++)
+            if (d == _near[dir])
+                return (std::uint64_t(dir) << 4) | 0x08 | low;
+        const std::uint64_t zz = (std::uint64_t(d) << 1) ^ std::uint64_t(d >> 63);
+        return (zz << 4) | low;
+    }
+
+    // Decodes one event and applies it to out; returns the cell index
+    std::size_t apply(const std::uint8_t*& p, CellIndex& base, StateMirror& out) const
+    {
+        const std::uint64_t v = getVarint(p);
+        std::int64_t d;
+        if (v & 0x08)
+            d = _near[(v >> 4) & 0x07];
+        else
+        {
+            const std::uint64_t zz = v >> 4;
+            d = std::int64_t(zz >> 1) ^ -std::int64_t(zz & 1);
+        }
+        base = CellIndex(std::int64_t(base) + d);
+        out.set(base, CellState((v >> 1) & 0x03), (v & 1) != 0);
+        return base;
+    }
+
+    void addKeyframe()
+    {
+        Keyframe k{_records, _events.size(), _base, _snap.size(), 0};
+        // in index order runs of cells along a row are +1 steps: one byte each
+        _sorted.clear();
+        _live.forEachSet([&](std::size_t i) { _sorted.push_back(CellIndex(i)); });
+        std::sort(_sorted.begin(), _sorted.end());
+        CellIndex base = 0;
+        for (CellIndex i : _sorted)
+            putVarint(_snap, encode(base, i, _live.state(i), _live.isBackward(i)));
+        k.snapEnd = _snap.size();
+        _keys.push_back(k);
+    }
+
+public:
+    // Starts a new recording for a grid of the given size
+    void reset(std::size_t cells, int cols)
+    {
+        const std::int64_t c = cols;
+        const std::int64_t near[8] = {-c - 1, -c, -c + 1, -1, 1, c - 1, c, c + 1};
+        std::copy(std::begin(near), std::end(near), std::begin(_near));
+        _events.clear();
+        _snap.clear();
+        _keys.clear();
+        _step.clear();
+        _records = 0;
+        _base = 0;
+        if (_live.size() != cells)
+            _live.resize(cells);
+        else
+            _live.clear();
+        _keys.push_back(Keyframe{0, 0, 0, 0, 0});
+    }
+
+    // Releases all memory
+    void release()
+    {
+        *this = SearchTrace();
+    }
+
+    bool empty() const { return _records == 0; }
+    // Recorded steps (step 0 = begin)
+    std::size_t steps() const { return _records; }
+    std::size_t keyframes() const { return _keys.size(); }
+    // Encoded size (events + keyframes)
+    std::size_t bytes() const { return _events.size() + _snap.size() + _keys.size() * sizeof(Keyframe); }
+
+    // ----- Recording -----
+    void add(std::size_t i, CellState s, bool backward)
+    {
+        _live.set(i, s, backward);
+        _step.push_back(encode(_base, i, s, backward));
+    }
+
+    void endStep()
+    {
+        putVarint(_events, _step.size());
+        for (std::uint64_t v : _step)
+            putVarint(_events, v);
+        _step.clear();
+        _records++;
+
+        const Keyframe& last = _keys.back();
+        if (_events.size() - last.offset >= std::max(cMinKeyGap, 2 * (last.snapEnd - last.snapBegin)))
+            addKeyframe();
+    }
+};
+
+// Replays a SearchTrace into a StateMirror: seek() moves to any recorded step,
+// forwards by decoding the steps in between, backwards (or far forwards) by
+// starting from the nearest keyframe.
+class TracePlayer
+{
+    const SearchTrace* _trace = nullptr;
+    std::size_t _records = 0;       // steps applied to the mirror
+    std::size_t _offset = 0;
+    CellIndex _base = 0;
+    bool _valid = false;            // the mirror holds the state of _records
+
+public:
+    // The mirror's contents are unknown until the first seek()
+    void attach(const SearchTrace& trace)
+    {
+        _trace = &trace;
+        _valid = false;
+    }
+
+    // Forgets what the mirror holds, as when the trace is recorded anew;
+    // the next seek() starts from a keyframe
+    void reset()
+    {
+        _records = 0;
+        _offset = 0;
+        _base = 0;
+        _valid = false;
+    }
+
+    // Step shown after the last seek()
+    std::size_t step() const { return _records > 0 ? _records - 1 : 0; }
+
+    // Sets out to the state after the given step (clamped to the last one).
+    // Calls changed(cellIndex) for every cell written while decoding events.
+    // Returns true if out was rebuilt from a keyframe instead; all cells may
+    // have changed then.
+    template <class Fn>
+    bool seek(std::size_t step, StateMirror& out, Fn&& changed)
+    {
+        const SearchTrace& t = *_trace;
+        if (t.empty())
+            return false;
+        const std::size_t target = std::min(step, t.steps() - 1) + 1;
+
+        const auto next = std::upper_bound(t._keys.begin(), t._keys.end(), target,
+            [](std::size_t rec, const SearchTrace::Keyframe& k) { return rec < k.records; });
+        const SearchTrace::Keyframe& key = *(next - 1);
+
+        bool rebuilt = false;
+        if (!_valid || _records > target || _records < key.records)
+        {
+            out.clear();
+            const std::uint8_t* p = t._snap.data() + key.snapBegin;
+            const std::uint8_t* end = t._snap.data() + key.snapEnd;
+            CellIndex base = 0;
+            while (p < end)
+                t.apply(p, base, out);
+            _records = key.records;
+            _offset = key.offset;
+            _base = key.base;
+            _valid = true;
+            rebuilt = true;
+        }
+
+        const std::uint8_t* p = t._events.data() + _offset;
+        for (; _records < target; _records++)
+        {
+            for (std::uint64_t n = SearchTrace::getVarint(p); n > 0; n--)
+            {
+                const std::size_t i = t.apply(p, _base, out);
+                if (!rebuilt)
+                    changed(i);
+            }
+        }
+        _offset = std::size_t(p - t._events.data());
+        return rebuilt;
+    }
+};
+
+} // namespace maze
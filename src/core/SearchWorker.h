@@ -0,0 +1,192 @@
+#pragma once
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <utility>
+#include <cstddef>
+
+#include "Grid.h"
+#include "SearchEngine.h"
+#include "SpscRing.h"
+#include "StepPacer.h"
+
+namespace maze
+{
+
+// New state of one cell, as seen right after the steps that changed it
+struct CellEvent
+{
+    CellIndex cell;
+    CellState state;
+    bool backward;
+};
+
+// Runs a SearchEngine on a dedicated thread so the UI thread only draws.
+//
+// The worker steps the engine at the requested speed (steps per second, 0 =
+// as fast as possible) and publishes every cell whose state changed as a
+// CellEvent through a lock-free single-producer/single-consumer ring; the UI
+// drains it once per frame into a StateMirror. When the ring is full the
+// worker waits, so a slow consumer throttles the search instead of growing a
+// queue. Live counters are published as a SearchStats snapshot.
+//
+// The engine belongs to the worker while busy(): the owner may only touch it
+// (and must not modify the grid) after stop() or once done() and finish().
+// stop() is prompt: the cancel flag is checked every few hundred steps, while
+// waiting for ring space, and by the engine inside its table builds and other
+// long single steps (SearchEngine::setCancelFlag); a search stopped inside
+// begin() is left not running. Events left in the ring after stopping are
+// still valid and should be drained; changes the worker had not published
+// yet stay in the engine's change log.
+class SearchWorker
+{
+    static constexpr std::size_t cRingSize = std::size_t(1) << 20;
+    // Steps between checks of the cancel flag and the speed
+    static constexpr std::size_t cBatch = 256;
+    // Longest sleep while waiting for the next paced step or for ring space
+    static constexpr std::chrono::microseconds cMaxNap{2000};
+
+    SearchEngine _engine;
+    SpscRing<CellEvent> _events{cRingSize};
+    std::thread _thread;
+    std::atomic<bool> _cancel{false};
+    std::atomic<bool> _done{false};
+    std::atomic<double> _rate{0};
+
+    mutable std::mutex _statsMtx;
+    SearchStats _stats;
+
+    void setStats(const SearchStats& st)
+    {
+        std::lock_guard<std::mutex> lock(_statsMtx);
+        _stats = st;
+    }
+
+    // Pushes the logged changes; false if cancelled while waiting for space
+    bool publish()
+    {
+        bool ok = true;
+        _engine.forEachChange([&](std::size_t i)
+        {
+            if (!ok)
+                return;
+            const CellEvent ev{CellIndex(i), _engine.state(i), _engine.isBackward(i)};
+            while (!_events.push(ev))
+            {
+                if (_cancel.load(std::memory_order_relaxed))
+                {
+                    ok = false;
+                    return;
+                }
+                std::this_thread::sleep_for(cMaxNap);
+            }
+        });
+        if (ok)
+            _engine.clearChanges();
+        setStats(_engine.stats());
+        return ok;
+    }
+
+    void loop()
+    {
+        _engine.begin();
+        StepPacer pacer;
+        pacer.setRate(_rate.load(std::memory_order_relaxed));
+        pacer.restart();
+
+        bool ok = publish();
+        while (ok && !_engine.isFinished() && !_cancel.load(std::memory_order_relaxed))
+        {
+            const double rate = _rate.load(std::memory_order_relaxed);
+            if (rate != pacer.rate())
+                pacer.setRate(rate);
+
+            const std::size_t due = std::min(pacer.available(), cBatch);
+            if (due == 0)
+            {
+                // sleep until the next step is due, waking up often enough to notice stop()
+                const auto next = std::chrono::duration<double>(1.0 / pacer.rate());
+                std::this_thread::sleep_for(std::min<std::chrono::duration<double>>(next, cMaxNap));
+                continue;
+            }
+
+            std::size_t steps = 0;
+            while (steps < due && !_engine.isFinished() && _engine.step())
+                steps++;
+            pacer.spend(steps);
+            ok = publish();
+            if (steps == 0)
+                break;
+        }
+        _done.store(true, std::memory_order_release);
+    }
+
+public:
+    SearchWorker()
+    {
+        _engine.trackChanges(true);
+        _engine.setCancelFlag(&_cancel);
+    }
+    ~SearchWorker() { stop(); }
+
+    SearchWorker(const SearchWorker&) = delete;
+    SearchWorker& operator=(const SearchWorker&) = delete;
+
+    // Only while !busy()
+    SearchEngine& engine() { return _engine; }
+    const SearchEngine& engine() const { return _engine; }
+
+    // A worker thread exists (running, or done but not finished yet)
+    bool busy() const { return _thread.joinable(); }
+    // The worker has published everything and exits; call finish()
+    bool done() const { return _done.load(std::memory_order_acquire); }
+
+    void setRate(double stepsPerSec) { _rate.store(std::max(0.0, stepsPerSec), std::memory_order_relaxed); }
+
+    // Starts a fresh search between the grid's start and goal on the worker
+    // thread (begin() included, so a JPS+ table is built there too)
+    void start(double stepsPerSec)
+    {
+        stop();
+        _cancel.store(false, std::memory_order_relaxed);
+        _done.store(false, std::memory_order_relaxed);
+        setRate(stepsPerSec);
+        setStats(SearchStats());
+        _thread = std::thread([this] { loop(); });
+    }
+
+    // Cancels a running search and waits for the thread
+    void stop()
+    {
+        if (!busy())
+            return;
+        _cancel.store(true, std::memory_order_relaxed);
+        _thread.join();
+        // the owner may step the engine itself now
+        _cancel.store(false, std::memory_order_relaxed);
+    }
+
+    // Joins a worker that is done()
+    void finish()
+    {
+        if (busy())
+            _thread.join();
+    }
+
+    // UI side: calls fn(const CellEvent&) for the published events, up to maxEvents
+    template <class Fn>
+    std::size_t drain(Fn&& fn, std::size_t maxEvents = std::size_t(-1))
+    {
+        return _events.drain(std::forward<Fn>(fn), maxEvents);
+    }
+
+    SearchStats stats() const
+    {
+        std::lock_guard<std::mutex> lock(_statsMtx);
+        return _stats;
+    }
+};
+
+} // namespace maze
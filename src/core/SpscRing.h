@@ -0,0 +1,69 @@
+#pragma once
+#include <vector>
+#include <atomic>
+#include <cstddef>
+
+namespace maze
+{
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. Capacity is rounded up to a power of two. Each side owns one index
+// and only reads the other, so push/pop need no locks and no CAS; the two
+// indices live on separate cache lines so the sides do not contend.
+template <class T>
+class SpscRing
+{
+    static constexpr std::size_t cLine = 64;
+
+    std::vector<T> _buf;
+    std::size_t _mask = 0;
+
+    alignas(cLine) std::atomic<std::size_t> _head{0};    // next slot to read (consumer)
+    alignas(cLine) std::atomic<std::size_t> _tail{0};    // next slot to write (producer)
+
+public:
+    explicit SpscRing(std::size_t capacity = 1024)
+    {
+        std::size_t n = 2;
+        while (n < capacity)
+            n *= 2;
+        _buf.resize(n);
+        _mask = n - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    std::size_t capacity() const { return _buf.size(); }
+
+    // Producer: false if the ring is full
+    bool push(const T& v)
+    {
+        const std::size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _head.load(std::memory_order_acquire) == _buf.size())
+            return false;
+        _buf[tail & _mask] = v;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: calls fn(item) for everything pushed so far, up to maxItems;
+    // returns the number of items taken
+    template <class Fn>
+    std::size_t drain(Fn&& fn, std::size_t maxItems = std::size_t(-1))
+    {
+        const std::size_t head = _head.load(std::memory_order_relaxed);
+        std::size_t n = _tail.load(std::memory_order_acquire) - head;
+        if (n > maxItems)
+            n = maxItems;
+        for (std::size_t k = 0; k < n; k++)
+            fn(_buf[(head + k) & _mask]);
+        _head.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    // Either side; exact only while the other side is idle
+    bool empty() const { return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire); }
+};
+
+} // namespace maze
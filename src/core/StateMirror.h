@@ -0,0 +1,76 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <cstddef>
+#include <cstdint>
+
+#include "MazeTypes.h"
+
+namespace maze
+{
+
+// Copy of the per-cell search states (CellState and side) that a view owns,
+// fed with the change events of a search running on another thread. It has
+// the state()/isBackward() interface of SearchEngine, so a CellRaster can
+// draw from either.
+//
+// One byte per cell. clear() only rewrites the cells set since the last
+// clear, so it costs in proportion to the previous search, not the maze.
+// Cells per CellState are counted as they change.
+class StateMirror
+{
+    static constexpr std::uint8_t cStateMask = 0x03;
+    static constexpr std::uint8_t cBackward = 0x04;
+
+    std::vector<std::uint8_t> _cells;
+    std::vector<CellIndex> _set;        // cells made non-empty since clear()
+    std::size_t _counts[4] = {};
+
+public:
+    void resize(std::size_t cells)
+    {
+        _cells.assign(cells, 0);
+        _set.clear();
+        std::fill(std::begin(_counts), std::end(_counts), 0);
+    }
+
+    std::size_t size() const { return _cells.size(); }
+
+    void clear()
+    {
+        for (CellIndex i : _set)
+            _cells[i] = 0;
+        _set.clear();
+        std::fill(std::begin(_counts), std::end(_counts), 0);
+    }
+
+    CellState state(std::size_t i) const { return CellState(_cells[i] & cStateMask); }
+    bool isBackward(std::size_t i) const { return (_cells[i] & cBackward) != 0; }
+
+    void set(std::size_t i, CellState s, bool backward)
+    {
+        std::uint8_t& v = _cells[i];
+        const std::uint8_t nv = std::uint8_t(std::uint8_t(s) | (backward ? cBackward : 0));
+        if (v == 0 && nv != 0)
+            _set.push_back(CellIndex(i));
+        _counts[v & cStateMask]--;
+        _counts[std::uint8_t(s)]++;
+        v = nv;
+    }
+
+    // Cells currently in state s (not meaningful for CellState::None)
+    std::size_t count(CellState s) const { return _counts[std::uint8_t(s)]; }
+
+    // Calls fn(cellIndex) for every cell that is not empty, in the order they
+    // were first set (a cell emptied and set again is reported twice)
+    template <class Fn>
+    void forEachSet(Fn&& fn) const
+    {
+        for (CellIndex i : _set)
+            if (_cells[i] != 0)
+                fn(std::size_t(i));
+    }
+};
+
+} // namespace maze
@@ -0,0 +1,68 @@
+#pragma once
+#include <chrono>
+#include <algorithm>
+#include <limits>
+#include <cstddef>
+
+namespace maze
+{
+
+// Converts an animation speed in steps per second into a step quota per frame,
+// independent of the frame rate. Credit accumulates with wall-clock time
+// (fractions carry over, so 1 step/s works at 60 fps) and is capped, so a
+// stalled frame does not cause a burst afterwards. Rate 0 means unlimited:
+// the caller runs until its frame time budget is used up.
+class StepPacer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr std::size_t cUnlimited = std::numeric_limits<std::size_t>::max();
+
+private:
+    // Most credit kept between frames (seconds of steps)
+    static constexpr double cMaxLagSec = 0.25;
+
+    double _rate = 0;
+    double _credit = 0;
+    Clock::time_point _last = Clock::now();
+
+public:
+    double rate() const { return _rate; }
+    bool unlimited() const { return _rate <= 0; }
+
+    void setRate(double stepsPerSec)
+    {
+        _rate = std::max(0.0, stepsPerSec);
+        _credit = std::min(_credit, maxCredit());
+    }
+
+    // Starts counting from now, with credit for one step so a run shows progress at once
+    void restart(Clock::time_point now = Clock::now())
+    {
+        _last = now;
+        _credit = 1;
+    }
+
+    // Steps that may run now
+    std::size_t available(Clock::time_point now = Clock::now())
+    {
+        if (unlimited())
+            return cUnlimited;
+        const double dt = std::chrono::duration<double>(now - _last).count();
+        _last = now;
+        _credit = std::min(_credit + dt * _rate, maxCredit());
+        return std::size_t(_credit);
+    }
+
+    // Records the steps actually run (may be fewer than available)
+    void spend(std::size_t steps)
+    {
+        if (!unlimited())
+            _credit = std::max(0.0, _credit - double(steps));
+    }
+
+private:
+    double maxCredit() const { return std::max(1.0, _rate * cMaxLagSec); }
+};
+
+} // namespace maze
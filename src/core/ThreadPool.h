@@ -0,0 +1,89 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+
+namespace maze
+{
+
+// Fixed set of worker threads for fork/join jobs: run(job) calls job(worker)
+// once on every worker and returns when all of them are done. Workers sleep
+// between jobs, so the threads are created once and reused for every batch.
+class ThreadPool
+{
+    std::vector<std::thread> _threads;
+    std::function<void(unsigned)> _job;
+
+    std::mutex _mtx;
+    std::condition_variable _cvStart;
+    std::condition_variable _cvDone;
+    std::uint64_t _generation = 0;      // bumped for every job
+    unsigned _pending = 0;              // workers still running the current job
+    bool _stop = false;
+
+    void workerLoop(unsigned worker)
+    {
+        std::uint64_t seen = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(_mtx);
+                _cvStart.wait(lock, [&] { return _stop || _generation != seen; });
+                if (_stop)
+                    return;
+                seen = _generation;
+            }
+
+            _job(worker);
+
+            std::lock_guard<std::mutex> lock(_mtx);
+            if (--_pending == 0)
+                _cvDone.notify_one();
+        }
+    }
+
+public:
+    // threads == 0 uses one worker per hardware thread
+    explicit ThreadPool(unsigned threads = 0)
+    {
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        _threads.reserve(threads);
+        for (unsigned i = 0; i < threads; i++)
+            _threads.emplace_back([this, i] { workerLoop(i); });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            _stop = true;
+        }
+        _cvStart.notify_all();
+        for (auto& t : _threads)
+            t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return unsigned(_threads.size()); }
+
+    // Runs job(worker) on all workers (worker = 0 .. size()-1) and waits
+    void run(std::function<void(unsigned)> job)
+    {
+        std::unique_lock<std::mutex> lock(_mtx);
+        _job = std::move(job);
+        _pending = size();
+        ++_generation;
+        _cvStart.notify_all();
+        _cvDone.wait(lock, [&] { return _pending == 0; });
+        _job = nullptr;
+    }
+};
+
+} // namespace maze